@@ -1,4 +1,5 @@
 import json
+import os
 import seaborn as sns
 import numpy as np
 import pandas as pd
@@ -61,14 +62,21 @@ def load_results(results_dir: str) -> Tuple[Dict[str, Any], List[Any]]:
 
     mpp_results_mem_access = json.load(open('mpp_access_memory.json', 'r'))['benchmarks']
 
-    return ({
+    results_all = {
         'jemalloc': jemalloc_results,
         'mimalloc': mimalloc_results,
         'mpp': mpp_results,
         'ptmalloc2': ptmalloc2_results,
         'ptmalloc3': ptmalloc3_results,
         'rpmalloc': rpmalloc_results,
-    }, mpp_results_mem_access)
+    }
+
+    # Targets added after the original set, older result sets don't have them
+    for optional in ['baseline', 'gcpp', 'hoard', 'ptmalloc2-tcache', 'snmalloc', 'tcmalloc']:
+        if os.path.exists(f'{results_dir}/{optional}.json'):
+            results_all[optional] = json.load(open(f'{results_dir}/{optional}.json', 'r'))['benchmarks']
+
+    return (results_all, mpp_results_mem_access)
 
 
 def filter_name(bm_name: str, bm_to_find: str) -> bool:
@@ -78,10 +86,347 @@ def filter_name(bm_name: str, bm_to_find: str) -> bool:
         not bm_name.endswith('_mean')
 
 
+def draw_baseline(ax, df: pd.DataFrame, column: str):
+    """Draws the mean of the baseline allocator as a horizontal line, so that the distance of
+    every other allocator to it is its overhead above the harness cost."""
+    baseline = df[df['allocator'] == 'baseline'][column]
+    if baseline.empty:
+        return
+    ax.axhline(baseline.mean(), 0, 1, color='grey', linestyle=':', label='baseline')
+
+
+def plot_complex_mt_scaling(results_all: Dict[str, Any], bm_name: str, out_file: str):
+    """Plots per-thread scaling efficiency of the multi-threaded BM_Complex:
+    OpsPerSecondPerThread(N) / OpsPerSecondPerThread(1)."""
+    results_scaling = []
+    for allocator, results in results_all.items():
+        per_thread = {}
+        for bm in results:
+            if not filter_name(bm['name'], bm_name) or 'OpsPerSecondPerThread' not in bm:
+                continue
+            per_thread.setdefault(bm['threads'], []).append(bm['OpsPerSecondPerThread'])
+
+        if 1 not in per_thread:
+            continue
+
+        single_thread = np.mean(per_thread[1])
+        for threads, ops in sorted(per_thread.items()):
+            results_scaling.append((allocator, threads, np.mean(ops) / single_thread))
+
+    if not results_scaling:
+        return
+
+    plt.figure()
+    df = pd.DataFrame(results_scaling, columns=['allocator', 'threads', 'efficiency'])
+    ax = sns.lineplot(x="threads", y="efficiency", hue="allocator", data=df, marker='o')
+    ax.set_xscale('log', base=2)
+    ax.set_title('Complex benchmark (scaling efficiency)')
+    plt.plot()
+    plt.savefig(out_file)
+
+
+def plot_complex_memory_efficiency(results_all: Dict[str, Any], bm_name: str, out_file: str):
+    """Plots throughput against memory efficiency (live requested bytes / RSS) of BM_Complex.
+    Allocators closer to the top right corner are both faster and waste less memory."""
+    results_efficiency = []
+    for allocator, results in results_all.items():
+        for bm in results:
+            if filter_name(bm['name'], bm_name) and 'LiveToRss' in bm:
+                results_efficiency.append((allocator, bm['LiveToRss'], bm['OpsPerSecond']))
+
+    if not results_efficiency:
+        return
+
+    plt.figure()
+    df = pd.DataFrame(results_efficiency, columns=['allocator', 'live_to_rss', 'ops_per_second'])
+    ax = sns.scatterplot(x="live_to_rss", y="ops_per_second", hue="allocator", data=df)
+    ax.set_xlabel('Live bytes / RSS')
+    ax.set_ylabel('Operations per second')
+    ax.set_title('Complex benchmark (throughput vs memory efficiency)')
+    plt.plot()
+    plt.savefig(out_file)
+
+
+def plot_cross_thread_free(results_all: Dict[str, Any], out_file: str):
+    """Plots BM_CrossThreadFree throughput (chunks freed by a thread other than the one that
+    allocated them) per producers/consumers configuration."""
+    results_remote = []
+    for allocator, results in results_all.items():
+        for bm in results:
+            if filter_name(bm['name'], 'BM_CrossThreadFree/') and 'ChunksPerSecond' in bm:
+                config = '/'.join(bm['name'].split('/')[1:3])
+                results_remote.append((allocator, config, bm['ChunksPerSecond']))
+
+    if not results_remote:
+        return
+
+    plt.figure()
+    df = pd.DataFrame(results_remote, columns=['allocator', 'config', 'chunks_per_second'])
+    ax = sns.barplot(x="config", y="chunks_per_second", hue="allocator", data=df)
+    ax.set_ylabel('Chunks per second')
+    ax.set_title('Cross-thread free benchmark (remote frees)')
+    plt.xticks(rotation=15)
+    plt.plot()
+    plt.savefig(out_file)
+
+
+def plot_sized_free(results_all: Dict[str, Any], out_file: str):
+    """Plots the time to free 4096 chunks of random size with and without the size
+    (BM_DeallocateManyRandomSized vs BM_DeallocateManyRandom), per allocator."""
+    results_free = []
+    for allocator, results in results_all.items():
+        for bm in results:
+            if filter_name(bm['name'], 'BM_DeallocateManyRandom/4096'):
+                results_free.append((allocator, 'unsized', bm['real_time']))
+            elif filter_name(bm['name'], 'BM_DeallocateManyRandomSized/4096'):
+                results_free.append((allocator, bm.get('label', 'sized'), bm['real_time']))
+
+    if not results_free:
+        return
+
+    plt.figure()
+    df = pd.DataFrame(results_free, columns=['allocator', 'free', 'time'])
+    ax = sns.barplot(x="allocator", y="time", hue="free", data=df)
+    ax.set_ylabel('Time (us)')
+    ax.set_title('Benchmark Deallocate 4096 (sized vs unsized free)')
+    plt.plot()
+    plt.savefig(out_file)
+
+
+def plot_memory_return(results_all: Dict[str, Any], out_file: str):
+    """Plots the share of the RSS growth BM_MemoryReturn still finds after the decay window and
+    after an explicit purge, per allocator and size mix."""
+    results_residual = []
+    for allocator, results in results_all.items():
+        for bm in results:
+            if filter_name(bm['name'], 'BM_MemoryReturn/heapMiB:512/') and 'ResidualRatio' in bm:
+                sizes = bm['name'].split('/')[2]
+                results_residual.append((allocator, f'{sizes} idle', bm['ResidualRatio']))
+                results_residual.append((allocator, f'{sizes} purged', bm['ResidualAfterPurgeRatio']))
+
+    if not results_residual:
+        return
+
+    plt.figure()
+    df = pd.DataFrame(results_residual, columns=['allocator', 'phase', 'residual'])
+    ax = sns.barplot(x="allocator", y="residual", hue="phase", data=df)
+    ax.set_ylabel('Residual RSS / RSS growth')
+    ax.set_title('Memory return after freeing a 512 MiB heap')
+    plt.xticks(rotation=15)
+    plt.plot()
+    plt.savefig(out_file)
+
+
+def plot_lifetimes(results_all: Dict[str, Any], out_file: str):
+    """Plots BM_Lifetimes throughput per object generation and the share of RSS still used by
+    live long-lived objects after the younger generations were freed, per allocator."""
+    results_ops = []
+    results_pinned = []
+    for allocator, results in results_all.items():
+        for bm in results:
+            if filter_name(bm['name'], 'BM_Lifetimes/allocs:1048576/') and 'OpsPerSecond' in bm:
+                for generation in ['Request', 'Session', 'Immortal']:
+                    results_ops.append((allocator, generation, bm[f'{generation}OpsPerSecond']))
+                # Missing if no iteration could be measured, see UnmeasuredIterations
+                if 'LongLivedToRss' in bm:
+                    results_pinned.append((allocator, 'session+immortal', bm['LongLivedToRss']))
+                    results_pinned.append((allocator, 'immortal', bm['ImmortalToRss']))
+
+    if not results_ops:
+        return
+
+    fig, (ax_ops, ax_pinned) = plt.subplots(1, 2, figsize=(14, 5))
+    df = pd.DataFrame(results_ops, columns=['allocator', 'generation', 'ops'])
+    sns.barplot(x="allocator", y="ops", hue="generation", data=df, ax=ax_ops)
+    ax_ops.set_ylabel('Operations per second')
+    ax_ops.set_title('Throughput per generation')
+    ax_ops.tick_params(axis='x', rotation=15)
+
+    df = pd.DataFrame(results_pinned, columns=['allocator', 'live', 'ratio'])
+    sns.barplot(x="allocator", y="ratio", hue="live", data=df, ax=ax_pinned)
+    ax_pinned.set_ylabel('Live bytes / RSS growth')
+    ax_pinned.set_title('Fragmentation left by long-lived objects')
+    ax_pinned.tick_params(axis='x', rotation=15)
+    plt.plot()
+    plt.savefig(out_file)
+
+
+def plot_thread_churn(results_all: Dict[str, Any], out_file: str):
+    """Plots BM_ThreadChurn thread throughput and the RSS left behind by exited threads, per
+    allocator and threads per wave."""
+    results_churn = []
+    for allocator, results in results_all.items():
+        for bm in results:
+            if filter_name(bm['name'], 'BM_ThreadChurn/') and '/ops:4096/' in bm['name'] \
+                    and 'ThreadsPerSecond' in bm:
+                threads = bm['name'].split('/')[1].split(':')[1]
+                results_churn.append((allocator, threads, bm['ThreadsPerSecond'],
+                                      bm['RssLeftBehind'] / 2**20))
+
+    if not results_churn:
+        return
+
+    df = pd.DataFrame(results_churn, columns=['allocator', 'threads', 'threads_per_second', 'rss'])
+    fig, (ax_threads, ax_rss) = plt.subplots(1, 2, figsize=(14, 5))
+    sns.barplot(x="allocator", y="threads_per_second", hue="threads", data=df, ax=ax_threads)
+    ax_threads.set_ylabel('Threads per second')
+    ax_threads.set_title('Thread churn throughput')
+    ax_threads.tick_params(axis='x', rotation=15)
+
+    sns.barplot(x="allocator", y="rss", hue="threads", data=df, ax=ax_rss)
+    ax_rss.set_ylabel('RSS left behind (MiB)')
+    ax_rss.set_title('Memory held by abandoned thread caches')
+    ax_rss.tick_params(axis='x', rotation=15)
+    plt.plot()
+    plt.savefig(out_file)
+
+
+def plot_numa_locality(results_all: Dict[str, Any], out_file: str):
+    """Plots BM_NumaLocality remote traversal penalty and the share of pages allocated on the
+    worker's own node, per allocator."""
+    results_numa = []
+    for allocator, results in results_all.items():
+        for bm in results:
+            if filter_name(bm['name'], 'BM_NumaLocality/listNodes:1048576/randomized:1/') \
+                    and 'RemotePenalty' in bm:
+                results_numa.append((allocator, bm['RemotePenalty'], bm.get('LocalPageRatio', 0)))
+
+    if not results_numa:
+        return
+
+    df = pd.DataFrame(results_numa, columns=['allocator', 'penalty', 'local_pages'])
+    fig, (ax_penalty, ax_local) = plt.subplots(1, 2, figsize=(14, 5))
+    sns.barplot(x="allocator", y="penalty", data=df, ax=ax_penalty)
+    ax_penalty.set_ylabel('Remote / local traversal time')
+    ax_penalty.set_title('Remote access penalty')
+    ax_penalty.tick_params(axis='x', rotation=15)
+
+    sns.barplot(x="allocator", y="local_pages", data=df, ax=ax_local)
+    ax_local.set_ylabel('Pages on the allocating node')
+    ax_local.set_title('Page locality')
+    ax_local.tick_params(axis='x', rotation=15)
+    plt.plot()
+    plt.savefig(out_file)
+
+
+def plot_size_classes(results_dir: str, out_prefix: str):
+    """Plots per-size allocation latency and wasted bytes (usable - requested) of
+    BM_SizeClassSweep, from the <allocator>-size-classes.csv logs of every allocator."""
+    frames = []
+    for file_name in sorted(os.listdir(results_dir)):
+        if file_name.endswith('-size-classes.csv'):
+            df = pd.read_csv(f'{results_dir}/{file_name}')
+            df['allocator'] = file_name[:-len('-size-classes.csv')]
+            frames.append(df)
+
+    if not frames:
+        return
+
+    df = pd.concat(frames)
+    df = df.groupby(['allocator', 'size'], as_index=False).mean(numeric_only=True)
+    df['wasted'] = (df['usable_size'] - df['size']).clip(lower=0)
+
+    plt.figure()
+    ax = sns.lineplot(x="size", y="alloc_ns", hue="allocator", data=df, linewidth=0.5)
+    ax.set_xscale('log', base=2)
+    ax.set_ylabel('Allocation latency (ns)')
+    ax.set_title('Size class sweep (allocation latency)')
+    plt.plot()
+    plt.savefig(f'{out_prefix}-latency.png')
+
+    plt.figure()
+    ax = sns.lineplot(x="size", y="wasted", hue="allocator", data=df[df['usable_size'] > 0],
+                      linewidth=0.5)
+    ax.set_xscale('log', base=2)
+    ax.set_ylabel('Wasted bytes (usable - requested)')
+    ax.set_title('Size class sweep (internal fragmentation)')
+    plt.plot()
+    plt.savefig(f'{out_prefix}-wasted.png')
+
+
+def plot_gc_comparison(results_all: Dict[str, Any], out_prefix: str):
+    """Compares the two garbage collected targets (mpp, gcpp): collection pauses of BM_ComplexGc
+    and linked list traversal time before/after a collection."""
+    collectors = [c for c in ['mpp', 'gcpp'] if c in results_all]
+    if len(collectors) < 2:
+        return
+
+    results_pauses = []
+    results_access = []
+    for collector in collectors:
+        for bm in results_all[collector]:
+            if filter_name(bm['name'], 'BM_ComplexGc/') and 'GcPauseP50Ns' in bm:
+                workload = bm['name'].split('Transition matrix: ')[-1].split('"')[0]
+                for percentile in ['P50', 'P99']:
+                    results_pauses.append((collector, f'{workload} {percentile}',
+                                           bm[f'GcPause{percentile}Ns']))
+            if filter_name(bm['name'], 'BM_AccessMemory') and '/8192/' in bm['name']:
+                results_access.append((collector, bm['name'].split('/')[0], bm['real_time']))
+
+    if results_pauses:
+        plt.figure()
+        df = pd.DataFrame(results_pauses, columns=['collector', 'pause', 'ns'])
+        ax = sns.barplot(x="pause", y="ns", hue="collector", data=df)
+        ax.set_title('Complex GC benchmark (collection pauses)')
+        plt.plot()
+        plt.savefig(f'{out_prefix}-pauses.png')
+
+    if results_access:
+        plt.figure()
+        df = pd.DataFrame(results_access, columns=['collector', 'name', 'time'])
+        ax = sns.barplot(x="name", y="time", hue="collector", data=df)
+        ax.set_ylabel('Time (microseconds)')
+        ax.set_title('Memory access benchmark after collection. List size = 8192')
+        plt.xticks(rotation=15)
+        plt.plot()
+        plt.savefig(f'{out_prefix}-locality.png')
+
+
+def plot_profile_sweep(results_dir: str, bm_name: str, out_file: str):
+    """Plots throughput against peak memory of every allocator/profile pair written by
+    run_profile_sweep.sh, and prints the fastest profile of each allocator."""
+    profiles_dir = f'{results_dir}/profiles'
+    if not os.path.isdir(profiles_dir):
+        return
+
+    results_profiles = []
+    for file_name in sorted(os.listdir(profiles_dir)):
+        if not file_name.endswith('.json'):
+            continue
+        results = json.load(open(f'{profiles_dir}/{file_name}', 'r'))
+        profile = results['context'].get('allocator_profile', 'default')
+        allocator = file_name[:-len(f'-{profile}.json')]
+        for bm in results['benchmarks']:
+            if filter_name(bm['name'], bm_name) and 'OpsPerSecond' in bm:
+                results_profiles.append((allocator, profile, bm['OpsPerSecond'],
+                                         bm['PeakMemoryUsage']))
+
+    if not results_profiles:
+        return
+
+    df = pd.DataFrame(results_profiles, columns=['allocator', 'profile', 'ops_per_second', 'memory'])
+    df = df.groupby(['allocator', 'profile'], as_index=False).mean()
+    for allocator, group in df.groupby('allocator'):
+        best = group.loc[group['ops_per_second'].idxmax()]
+        print(f'{allocator}: fastest profile {best["profile"]} '
+              f'({best["ops_per_second"]:.0f} ops/s, {best["memory"]:.0f} peak memory)')
+
+    plt.figure()
+    ax = sns.scatterplot(x="memory", y="ops_per_second", hue="allocator", data=df)
+    for _, row in df.iterrows():
+        ax.annotate(row['profile'], (row['memory'], row['ops_per_second']), fontsize=5)
+    ax.set_xlabel('Peak memory usage')
+    ax.set_ylabel('Operations per second')
+    ax.set_title('Complex benchmark (tuning profiles)')
+    plt.plot()
+    plt.savefig(out_file)
+
+
 def main():
     setup_style()
 
-    results_all, results_mpp_mem_acc = load_results('2022-10-26T-16_26_25Z')
+    results_dir = '2022-10-26T-16_26_25Z'
+    results_all, results_mpp_mem_acc = load_results(results_dir)
 
     complex_pick = [
         "BM_Complex/\"Total ops: \" \"200'000\" \"Transition matrix: ver-1\"/iterations:5",
@@ -139,6 +484,21 @@ def main():
         ]
         results_deallocate_4096.append((allocator, bm_name, np.array(bm_mean_time)))
 
+    plot_complex_mt_scaling(
+        results_all,
+        "BM_Complex/\"Total ops: \" \"1'000'000\" \"Transition matrix: ver-1\"/iterations:5/real_time/threads:",
+        'complex_1m_mt-scaling.png')
+    plot_complex_memory_efficiency(results_all, complex_pick[1], 'complex_1m-efficiency.png')
+    plot_cross_thread_free(results_all, 'cross_thread_free.png')
+    plot_sized_free(results_all, 'sized_free.png')
+    plot_memory_return(results_all, 'memory_return.png')
+    plot_lifetimes(results_all, 'lifetimes.png')
+    plot_thread_churn(results_all, 'thread_churn.png')
+    plot_numa_locality(results_all, 'numa_locality.png')
+    plot_size_classes(results_dir, 'size_classes')
+    plot_gc_comparison(results_all, 'gc_mpp_vs_gcpp')
+    plot_profile_sweep(results_dir, complex_pick[1], 'complex_1m-profiles.png')
+
     # fig, ax = plt.subplots()
     # for allocator, bm_name, bm_mean, bm_stddev in results_200k:
     #     x = np.linspace(bm_mean - 3 * bm_stddev, bm_mean + 3 * bm_stddev, 1000)
@@ -152,6 +512,7 @@ def main():
     ax = sns.boxplot(x="allocator", y="time", data=df)
     ax.set_title('Benchmark Allocate 4096 (time)')
     ax.axhline(df[df['allocator'] == 'mpp']['time'].mean(), 0, 1, color='r', linestyle='--')
+    draw_baseline(ax, df, 'time')
     plt.plot()
     plt.savefig('allocate-4096-time.png')
 
@@ -161,6 +522,7 @@ def main():
     ax = sns.boxplot(x="allocator", y="time", data=df)
     ax.set_title('Benchmark Deallocate 4096 (time)')
     ax.axhline(df[df['allocator'] == 'mpp']['time'].mean(), 0, 1, color='r', linestyle='--')
+    draw_baseline(ax, df, 'time')
     plt.plot()
     plt.savefig('deallocate-4096-time.png')
 
@@ -172,6 +534,7 @@ def main():
     ax = sns.boxplot(x="allocator", y="mean", data=df)
     ax.set_title('Complex benchmark 200k (time)')
     ax.axhline(df[df['allocator'] == 'mpp']['mean'].mean(), 0, 1, color='r', linestyle='--')
+    draw_baseline(ax, df, 'mean')
     plt.plot()
     plt.savefig('complex_200k-time.png')
 
@@ -191,6 +554,7 @@ def main():
     ax = sns.boxplot(x="allocator", y="mean", data=df)
     ax.set_title('Complex benchmark 1m (time)')
     ax.axhline(df[df['allocator'] == 'mpp']['mean'].mean(), 0, 1, color='r', linestyle='--')
+    draw_baseline(ax, df, 'mean')
     plt.plot()
     plt.savefig('complex_1m-time.png')
 
@@ -209,6 +573,7 @@ def main():
     ax = sns.boxplot(x="allocator", y="mean", data=df)
     ax.set_title('Complex benchmark 2m (time)')
     ax.axhline(df[df['allocator'] == 'mpp']['mean'].mean(), 0, 1, color='r', linestyle='--')
+    draw_baseline(ax, df, 'mean')
     plt.plot()
     plt.savefig('complex_2m-time.png')
 
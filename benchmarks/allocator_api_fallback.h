@@ -0,0 +1,46 @@
+#pragma once
+
+#include "allocator_api_override.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief Generic implementations of the optional shim operations on top of BenchmarkAllocate()
+ * and BenchmarkDeallocate(), for allocators that don't provide them natively.
+ */
+namespace bm::fallback {
+    //! @brief Always allocates a new chunk and copies min(old, new) bytes into it.
+    inline void* Reallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+    {
+        void* newPtr = BenchmarkAllocate(t_newSize);
+        if (t_ptr != nullptr) {
+            if (newPtr != nullptr)
+                std::memcpy(newPtr, t_ptr, std::min(t_oldSize, t_newSize));
+            BenchmarkDeallocate(t_ptr);
+        }
+
+        return newPtr;
+    }
+
+    //! @brief Allocates t_count * t_size bytes and clears them.
+    inline void* AllocateZeroed(std::size_t t_count, std::size_t t_size)
+    {
+        std::size_t total = 0;
+        if (__builtin_mul_overflow(t_count, t_size, &total))
+            return nullptr;
+
+        void* ptr = BenchmarkAllocate(total);
+        if (ptr != nullptr)
+            std::memset(ptr, 0, total);
+
+        return ptr;
+    }
+
+    //! @brief Ignores the size hint.
+    inline void DeallocateSized(void* t_ptr, std::size_t t_size)
+    {
+        BenchmarkDeallocate(t_ptr);
+    }
+}
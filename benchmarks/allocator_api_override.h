@@ -1,10 +1,86 @@
+#pragma once
+
 #include <cstddef>
+#include <cstdint>
 
 #define FORCENOINLINE __attribute__((__noinline__))
 
-extern FORCENOINLINE void BenchmarkAllocatorInitialize();
+/**
+ * @brief Flags returned by BenchmarkAllocatorCapabilities(). Operations without the "native" flag
+ * are still callable, but go through the generic fallbacks from allocator_api_fallback.h.
+ */
+enum BenchmarkCapability : uint32_t
+{
+    //! @brief Allocator can be used from multiple threads at once.
+    kBenchmarkCapThreadSafe = 1 << 0,
+    //! @brief BenchmarkReallocate() is native (may grow/shrink in place, no forced copy).
+    kBenchmarkCapNativeReallocate = 1 << 1,
+    //! @brief BenchmarkAllocateZeroed() is native (may skip memset for fresh pages).
+    kBenchmarkCapNativeAllocateZeroed = 1 << 2,
+    //! @brief BenchmarkDeallocateSized() is native (skips the size lookup).
+    kBenchmarkCapNativeDeallocateSized = 1 << 3,
+    //! @brief BenchmarkAllocateAligned() is supported. There is no generic fallback for it.
+    kBenchmarkCapAllocateAligned = 1 << 4,
+};
+
+/**
+ * @brief Memory held by the allocator, as reported by the allocator itself. Fields the allocator
+ * doesn't report are left as 0.
+ */
+struct BenchmarkAllocatorStats
+{
+    //! @brief Bytes in pages that contain live allocations (includes internal fragmentation).
+    std::size_t activeBytes = 0;
+    //! @brief Bytes mapped/committed from the OS (includes free and cached memory).
+    std::size_t mappedBytes = 0;
+};
+
+/**
+ * @brief Initializes the allocator with the tuning profile t_profile (see allocator_profiles.h).
+ * "default" keeps the compiled-in defaults and is known to every target.
+ * @return false if the target doesn't know t_profile or the allocator failed to initialize.
+ */
+extern FORCENOINLINE bool BenchmarkAllocatorInitialize(const char* t_profile);
+//! @brief Returns the names of the profiles the target knows, "default" first, nullptr-terminated.
+extern FORCENOINLINE const char* const* BenchmarkAllocatorProfiles();
 extern FORCENOINLINE void BenchmarkAllocatorFinalize();
 extern FORCENOINLINE void* BenchmarkAllocate(std::size_t t_size);
 extern FORCENOINLINE void BenchmarkDeallocate(void* t_ptr);
 
-#undef FORCENOINLINE
\ No newline at end of file
+extern FORCENOINLINE void BenchmarkThreadInitialize();
+extern FORCENOINLINE void BenchmarkThreadFinalize();
+extern FORCENOINLINE uint32_t BenchmarkAllocatorCapabilities();
+
+extern FORCENOINLINE void* BenchmarkReallocate(void* t_ptr,
+                                               std::size_t t_oldSize,
+                                               std::size_t t_newSize);
+extern FORCENOINLINE void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size);
+extern FORCENOINLINE void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size);
+extern FORCENOINLINE void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size);
+/**
+ * @brief Returns how many bytes of the chunk at t_ptr are usable, i.e. the size of its size class.
+ * @return 0 if the allocator can't tell.
+ */
+extern FORCENOINLINE std::size_t BenchmarkUsableSize(void* t_ptr);
+
+/**
+ * @brief Queries allocator statistics. Can be slow (may refresh or walk allocator state), so it
+ * shouldn't be called per operation.
+ * @return false if the allocator doesn't expose statistics (or they are compiled out).
+ */
+extern FORCENOINLINE bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats);
+
+/**
+ * @brief Asks the allocator to return the memory it caches to the OS (malloc_trim, arena purge,
+ * ...). Can be slow.
+ * @return false if the allocator has no way to do that.
+ */
+extern FORCENOINLINE bool BenchmarkAllocatorPurge();
+
+//! @brief Returns true if the allocator reports all of the t_capabilities flags.
+inline bool BenchmarkAllocatorHas(uint32_t t_capabilities)
+{
+    return (BenchmarkAllocatorCapabilities() & t_capabilities) == t_capabilities;
+}
+
+#undef FORCENOINLINE
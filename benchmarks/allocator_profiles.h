@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * @brief Helpers for the tuning profiles accepted by BenchmarkAllocatorInitialize(). Targets with
+ * tunables keep a table of profile structs (each starting with `const char* name`), the others
+ * only know "default".
+ */
+namespace bm::profiles {
+    //! @brief Profile that keeps the allocator's compiled-in defaults, known to every target.
+    constexpr const char* c_default = "default";
+
+    //! @brief Returns the profile selected with MPP_BENCH_PROFILE, "default" if it isn't set.
+    inline const char* GetSelectedProfile()
+    {
+        const char* profile = std::getenv("MPP_BENCH_PROFILE");
+        return (profile != nullptr && *profile != '\0') ? profile : c_default;
+    }
+
+    inline bool IsDefault(const char* t_profile)
+    {
+        return std::strcmp(t_profile, c_default) == 0;
+    }
+
+    //! @brief Profile list of targets without tunables.
+    inline const char* const* DefaultOnly()
+    {
+        static const char* const c_profiles[] = { c_default, nullptr };
+        return c_profiles;
+    }
+
+    //! @return Profile named t_name in t_profiles, nullptr if there is none.
+    template<class Profile, std::size_t N>
+    const Profile* Find(const Profile (&t_profiles)[N], const char* t_name)
+    {
+        for (const Profile& profile : t_profiles) {
+            if (std::strcmp(profile.name, t_name) == 0)
+                return &profile;
+        }
+
+        return nullptr;
+    }
+
+    //! @return nullptr-terminated names of t_profiles, as returned by BenchmarkAllocatorProfiles().
+    template<class Profile, std::size_t N>
+    const char* const* Names(const Profile (&t_profiles)[N])
+    {
+        static const char* names[N + 1] = {};
+        for (std::size_t i = 0; i < N; ++i)
+            names[i] = t_profiles[i].name;
+        return names;
+    }
+}
@@ -0,0 +1,318 @@
+/**
+ * @file Baseline "allocator": a thread-local bump arena with size-class LIFO free lists.
+ * It does the least work any allocator can do (no coalescing, no returning memory to the OS, no
+ * synchronization), so its results are a lower bound for the harness + workload cost of every
+ * benchmark. Subtract them from other allocators' numbers to get the allocator's own overhead.
+ *
+ * A pure bump allocator with a no-op free isn't usable here: a single BM_Complex iteration
+ * requests hundreds of gigabytes in total, so freed chunks are recycled per size class. For the
+ * same reason the arena of an exited thread (its block and free lists) is handed to the next
+ * thread that needs a block, instead of mapping a new one for every thread.
+ */
+#include "allocator_api_fallback.h"
+#include "allocator_api_override.h"
+#include "allocator_profiles.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <sys/mman.h>
+#include <vector>
+
+namespace {
+    //! @brief Every chunk is preceded by a header with its size class (keeps 16 byte alignment)
+    constexpr std::size_t c_headerSize = 16;
+    constexpr std::size_t c_alignment = 16;
+    constexpr std::size_t c_pageSize = 4096;
+    //! @brief Sizes up to this are rounded to c_alignment
+    constexpr std::size_t c_tinySizeMax = 64;
+    constexpr std::size_t c_tinyClasses = c_tinySizeMax / c_alignment;
+    //! @brief log2 of c_tinySizeMax, bigger sizes get 4 classes per power of two
+    constexpr uint32_t c_tinySizeMaxShift = 6;
+    //! @brief log2 of the biggest recycled chunk. Bigger chunks are never recycled
+    constexpr uint32_t c_largeSizeMaxShift = 24;
+    //! @brief Class 0 marks chunks that are not recycled
+    constexpr std::size_t c_totalClasses =
+        c_tinyClasses + (c_largeSizeMaxShift - c_tinySizeMaxShift) * 4 + 1;
+    //! @brief Size of the blocks the arenas are refilled with
+    constexpr std::size_t c_blockSize = 64 * 1024 * 1024;
+
+    struct FreeChunk
+    {
+        FreeChunk* next;
+    };
+
+    struct ThreadArena
+    {
+        char* cur;
+        char* end;
+        FreeChunk* freeLists[c_totalClasses];
+    };
+
+    // Zero-initialized, so that accesses don't need a TLS init guard. Chunks freed by another
+    // thread go to that thread's free lists: arenas are never unmapped, so this is safe.
+    thread_local ThreadArena g_threadArena;
+
+    std::atomic<std::size_t> g_mappedBytes{ 0 };
+
+    //! @brief Arenas of exited threads, adopted by threads that need their first block
+    std::mutex g_orphanedArenasLock;
+    std::vector<ThreadArena> g_orphanedArenas;
+
+    bool IsEmpty(const ThreadArena& t_arena)
+    {
+        if (t_arena.end != nullptr)
+            return false;
+        for (FreeChunk* freeList : t_arena.freeLists) {
+            if (freeList != nullptr)
+                return false;
+        }
+        return true;
+    }
+
+    //! @brief Hands the block and free lists of t_arena to the orphaned arenas, resets t_arena
+    void ReleaseArena(ThreadArena& t_arena)
+    {
+        if (IsEmpty(t_arena))
+            return;
+
+        std::lock_guard<std::mutex> lock(g_orphanedArenasLock);
+        g_orphanedArenas.push_back(t_arena);
+        t_arena = ThreadArena{};
+    }
+
+    /**
+     * @brief Takes over the most recently orphaned arena: its block replaces the (used up) one of
+     * t_arena, its free lists are appended to the ones of t_arena.
+     * @return false if there is no orphaned arena
+     */
+    bool AdoptOrphanedArena(ThreadArena& t_arena)
+    {
+        ThreadArena orphan;
+        {
+            std::lock_guard<std::mutex> lock(g_orphanedArenasLock);
+            if (g_orphanedArenas.empty())
+                return false;
+            orphan = g_orphanedArenas.back();
+            g_orphanedArenas.pop_back();
+        }
+
+        t_arena.cur = orphan.cur;
+        t_arena.end = orphan.end;
+        for (std::size_t sizeClass = 0; sizeClass < c_totalClasses; ++sizeClass) {
+            FreeChunk*& freeList = t_arena.freeLists[sizeClass];
+            if (freeList == nullptr) {
+                freeList = orphan.freeLists[sizeClass];
+                continue;
+            }
+            // Only if the thread freed chunks of other threads before it had a block of its own
+            FreeChunk* tail = freeList;
+            while (tail->next != nullptr)
+                tail = tail->next;
+            tail->next = orphan.freeLists[sizeClass];
+        }
+        return true;
+    }
+
+    /**
+     * @brief Releases the arena when the thread exits, also if it never called
+     * BenchmarkThreadFinalize(). Constructed (and registered) with the first block of a thread.
+     */
+    struct ArenaReleaser
+    {
+        bool active = false;
+
+        ~ArenaReleaser()
+        {
+            ReleaseArena(g_threadArena);
+        }
+    };
+    thread_local ArenaReleaser g_arenaReleaser;
+
+    inline std::size_t AlignUp(std::size_t t_value, std::size_t t_alignment)
+    {
+        return (t_value + t_alignment - 1) & ~(t_alignment - 1);
+    }
+
+    /**
+     * @brief Returns the size class of t_size and sets t_rounded to the size of that class. Up to
+     * c_tinySizeMax classes are c_alignment apart, above it there are 4 classes per power of two
+     * (at most 25% internal fragmentation). Exact-size classes would hardly ever be reused by the
+     * random sizes of the benchmarks, and memory usage would explode.
+     */
+    inline uint64_t GetSizeClass(std::size_t t_size, std::size_t& t_rounded)
+    {
+        if (t_size <= c_tinySizeMax) {
+            t_rounded = AlignUp(t_size ? t_size : 1, c_alignment);
+            return t_rounded / c_alignment;
+        }
+
+        // t_size is in (2^shift, 2^(shift + 1)]
+        uint32_t shift = 63 - __builtin_clzll(t_size - 1);
+        std::size_t step = std::size_t(1) << (shift - 2);
+        t_rounded = AlignUp(t_size, step);
+        if (shift >= c_largeSizeMaxShift)
+            return 0;
+        // (t_rounded - 1) >> (shift - 2) is in [4, 7]
+        return c_tinyClasses + (shift - c_tinySizeMaxShift) * 4 +
+               ((t_rounded - 1) >> (shift - 2)) - 3;
+    }
+
+    //! @brief Inverse of GetSizeClass(): the rounded size of t_sizeClass, 0 for class 0
+    inline std::size_t GetClassSize(uint64_t t_sizeClass)
+    {
+        if (t_sizeClass <= c_tinyClasses)
+            return t_sizeClass * c_alignment;
+
+        uint64_t idx = t_sizeClass - c_tinyClasses - 1;
+        uint32_t shift = c_tinySizeMaxShift + idx / 4;
+        return (idx % 4 + 5) << (shift - 2);
+    }
+
+    /**
+     * @brief Gives t_arena a block with at least t_size free bytes (the rest of the old one is
+     * lost). The first block of a thread is taken from an orphaned arena if there is one, else a
+     * new block is mapped.
+     */
+    bool RefillArena(ThreadArena& t_arena, std::size_t t_size)
+    {
+        if (t_arena.end == nullptr) {
+            g_arenaReleaser.active = true;
+            if (AdoptOrphanedArena(t_arena) &&
+                static_cast<std::size_t>(t_arena.end - t_arena.cur) >= t_size)
+                return true;
+        }
+
+        std::size_t blockSize = std::max(c_blockSize, AlignUp(t_size, c_pageSize));
+        void* block = mmap(nullptr,
+                           blockSize,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                           -1,
+                           0);
+        if (block == MAP_FAILED)
+            return false;
+
+        g_mappedBytes.fetch_add(blockSize, std::memory_order_relaxed);
+        t_arena.cur = static_cast<char*>(block);
+        t_arena.end = t_arena.cur + blockSize;
+        return true;
+    }
+
+    /**
+     * @brief Bumps t_size bytes (plus header and padding for t_alignment) off the arena.
+     * @return User pointer, with the header in front of it set to t_sizeClass
+     */
+    inline void* BumpAllocate(std::size_t t_size, std::size_t t_alignment, uint64_t t_sizeClass)
+    {
+        ThreadArena& arena = g_threadArena;
+        std::size_t total = c_headerSize + t_size + (t_alignment - c_alignment);
+        if (static_cast<std::size_t>(arena.end - arena.cur) < total &&
+            !RefillArena(arena, total))
+            return nullptr;
+
+        char* ptr = reinterpret_cast<char*>(
+            AlignUp(reinterpret_cast<uintptr_t>(arena.cur) + c_headerSize, t_alignment));
+        arena.cur = ptr + t_size;
+        *reinterpret_cast<uint64_t*>(ptr - c_headerSize) = t_sizeClass;
+        return ptr;
+    }
+}
+
+bool BenchmarkAllocatorInitialize(const char* t_profile)
+{
+    return bm::profiles::IsDefault(t_profile);
+}
+
+const char* const* BenchmarkAllocatorProfiles()
+{
+    return bm::profiles::DefaultOnly();
+}
+
+void BenchmarkAllocatorFinalize()
+{
+    return;
+}
+
+void* BenchmarkAllocate(std::size_t t_size)
+{
+    std::size_t rounded;
+    uint64_t sizeClass = GetSizeClass(t_size, rounded);
+
+    FreeChunk*& freeList = g_threadArena.freeLists[sizeClass];
+    if (sizeClass != 0 && freeList != nullptr) {
+        FreeChunk* chunk = freeList;
+        freeList = chunk->next;
+        return chunk;
+    }
+
+    return BumpAllocate(rounded, c_alignment, sizeClass);
+}
+
+void BenchmarkDeallocate(void* t_ptr)
+{
+    if (t_ptr == nullptr)
+        return;
+
+    uint64_t sizeClass = *reinterpret_cast<uint64_t*>(static_cast<char*>(t_ptr) - c_headerSize);
+    if (sizeClass == 0)
+        return;
+
+    FreeChunk* chunk = static_cast<FreeChunk*>(t_ptr);
+    chunk->next = g_threadArena.freeLists[sizeClass];
+    g_threadArena.freeLists[sizeClass] = chunk;
+}
+
+void BenchmarkThreadInitialize()
+{
+    return;
+}
+void BenchmarkThreadFinalize()
+{
+    ReleaseArena(g_threadArena);
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    return kBenchmarkCapThreadSafe | kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return bm::fallback::Reallocate(t_ptr, t_oldSize, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    // Aligned chunks can't be handed out for other alignments, so they are never recycled
+    return BumpAllocate(AlignUp(t_size, c_alignment), std::max(t_alignment, c_alignment), 0);
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return bm::fallback::AllocateZeroed(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    bm::fallback::DeallocateSized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    uint64_t sizeClass = *reinterpret_cast<uint64_t*>(static_cast<char*>(t_ptr) - c_headerSize);
+    return GetClassSize(sizeClass);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+    // Live bytes aren't tracked (that would cost a counter update per operation)
+    t_stats.mappedBytes = g_mappedBytes.load(std::memory_order_relaxed);
+    return true;
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    // Arenas are never unmapped
+    return false;
+}
@@ -2,60 +2,70 @@
 #include "benchmark/benchmark.h"
 #include "benchmark_constants.h"
 #include "benchmark_utils.h"
+#include "workload_generator.h"
+#include "latency_histogram.h"
+
+#include <chrono>
+#include <vector>
 
 #define BENCH_ALLOC_BLUEPRINT(BM_NAME, sizes)                                                      \
     static void BM_NAME(benchmark::State& state)                                                   \
     {                                                                                              \
+        bm::utils::LatencyHistogram allocLatency;                                                  \
+        const auto requestSizes = bm::utils::PrecomputeSizes(                                      \
+            bm::workload::GetSizes(sizes), state.range(0), 1337 + 1);                              \
+        std::vector<void*> pointers(state.range(0));                                               \
         for (auto _ : state) {                                                                     \
-            state.PauseTiming();                                                                   \
-            bm::utils::XorshiftInit(1337 + 1);                                                     \
-            std::vector<void*> pointers;                                                           \
-            pointers.reserve(state.range(0));                                                      \
-            state.ResumeTiming();                                                                  \
-            for (uint32_t iter = 0; iter < state.range(0); ++iter) {                               \
-                pointers.emplace_back(                                                             \
-                    BenchmarkAllocate(sizes[bm::utils::XorshiftNext() % sizes.size()]));           \
-            }                                                                                      \
-            state.PauseTiming();                                                                   \
+            auto start = std::chrono::high_resolution_clock::now();                                \
+            for (std::size_t iter = 0; iter < requestSizes.size(); ++iter)                         \
+                pointers[iter] =                                                                   \
+                    bm::utils::InstrumentedAllocate(allocLatency, requestSizes[iter]);             \
+            auto end = std::chrono::high_resolution_clock::now();                                  \
+            state.SetIterationTime(                                                                \
+                std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());   \
             for (auto ptr : pointers)                                                              \
                 BenchmarkDeallocate(ptr);                                                          \
-            state.ResumeTiming();                                                                  \
         }                                                                                          \
+        bm::utils::ExportInstrumentedLatency(state, allocLatency, "AllocLatency");                 \
     }
 
 /**
  * @brief Benchmarks the allocation speed for many different small allocation requests.
  */
-BENCH_ALLOC_BLUEPRINT(DISABLED_BM_AllocateManySmallRandom, g_smallSizes);
+BENCH_ALLOC_BLUEPRINT(DISABLED_BM_AllocateManySmallRandom, "small");
 BENCHMARK(DISABLED_BM_AllocateManySmallRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalAllocOpsRangeStart, g_totalAllocOpsRangeEndSmall)
-    ->Unit(benchmark::kMicrosecond);
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
 
 /**
  * @brief Benchmarks the allocation speed for many different medium allocation requests.
  */
-BENCH_ALLOC_BLUEPRINT(DISABLED_BM_AllocateManyMediumRandom, g_mediumSizes);
+BENCH_ALLOC_BLUEPRINT(DISABLED_BM_AllocateManyMediumRandom, "medium");
 BENCHMARK(DISABLED_BM_AllocateManyMediumRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalAllocOpsRangeStart, g_totalAllocOpsRangeEndMedium)
-    ->Unit(benchmark::kMicrosecond);
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
 
 /**
  * @brief Benchmarks the allocation speed for many different huge allocations.
  */
-BENCH_ALLOC_BLUEPRINT(DISABLED_BM_AllocateManyBigRandom, g_bigSizes);
+BENCH_ALLOC_BLUEPRINT(DISABLED_BM_AllocateManyBigRandom, "big");
 BENCHMARK(DISABLED_BM_AllocateManyBigRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalAllocOpsRangeStart, g_totalAllocOpsRangeEndBig)
-    ->Unit(benchmark::kMicrosecond);
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
 
 /**
  * @brief Benchmarks the allocation speed for many differently sized objects (including small,
  * medium and big sizes).
  */
-BENCH_ALLOC_BLUEPRINT(BM_AllocateManyRandom, g_combinedSizes);
+BENCH_ALLOC_BLUEPRINT(BM_AllocateManyRandom, "combined");
 BENCHMARK(BM_AllocateManyRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalAllocOpsRangeStart, g_totalAllocOpsRangeEndCombined)
-    ->Unit(benchmark::kMicrosecond);
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
@@ -2,14 +2,17 @@
 #include "benchmark/benchmark.h"
 #include "benchmark_constants.h"
 #include "benchmark_utils.h"
+#include "workload_generator.h"
 
 #define BENCH_ALLOC_DEALLOC_BLUEPRINT(BM_NAME, sizes)                                              \
     static void BM_NAME(benchmark::State& state)                                                   \
     {                                                                                              \
+        const auto& requestSizes = bm::workload::GetSizes(sizes);                                  \
         bm::utils::XorshiftInit(1337 + 3);                                                         \
         for (auto _ : state) {                                                                     \
             for (uint32_t iter = 0; iter < state.range(0); ++iter) {                               \
-                void* ptr = BenchmarkAllocate(sizes[bm::utils::XorshiftNext() % sizes.size()]);    \
+                void* ptr = BenchmarkAllocate(                                                     \
+                    requestSizes[bm::utils::XorshiftNext() % requestSizes.size()]);                \
                 BenchmarkDeallocate(ptr);                                                          \
             }                                                                                      \
         }                                                                                          \
@@ -18,7 +21,7 @@
 /**
  * @brief Benchmarks combined allocation and deallocation speed for many different small sizes.
  */
-BENCH_ALLOC_DEALLOC_BLUEPRINT(DISABLED_BM_AllocateDeallocateManySmallRandom, g_smallSizes);
+BENCH_ALLOC_DEALLOC_BLUEPRINT(DISABLED_BM_AllocateDeallocateManySmallRandom, "small");
 BENCHMARK(DISABLED_BM_AllocateDeallocateManySmallRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalOpsRangeStart, g_totalOpsRangeEnd)
@@ -27,7 +30,7 @@ BENCHMARK(DISABLED_BM_AllocateDeallocateManySmallRandom)
 /**
  * @brief Benchmarks combined allocation and deallocation speed for many different medium sizes.
  */
-BENCH_ALLOC_DEALLOC_BLUEPRINT(DISABLED_BM_AllocateDeallocateManyMediumRandom, g_mediumSizes);
+BENCH_ALLOC_DEALLOC_BLUEPRINT(DISABLED_BM_AllocateDeallocateManyMediumRandom, "medium");
 BENCHMARK(DISABLED_BM_AllocateDeallocateManyMediumRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalOpsRangeStart, g_totalOpsRangeEnd)
@@ -36,7 +39,7 @@ BENCHMARK(DISABLED_BM_AllocateDeallocateManyMediumRandom)
 /**
  * @brief Benchmarks combined allocation and deallocation speed for many different big sizes.
  */
-BENCH_ALLOC_DEALLOC_BLUEPRINT(DISABLED_BM_AllocateDeallocateManyBigRandom, g_bigSizes);
+BENCH_ALLOC_DEALLOC_BLUEPRINT(DISABLED_BM_AllocateDeallocateManyBigRandom, "big");
 BENCHMARK(DISABLED_BM_AllocateDeallocateManyBigRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalOpsRangeStart, g_totalOpsRangeEnd)
@@ -47,7 +50,7 @@ BENCHMARK(DISABLED_BM_AllocateDeallocateManyBigRandom)
  objects
  * (including small, medium and big sizes).
  */
-BENCH_ALLOC_DEALLOC_BLUEPRINT(BM_AllocateDeallocateManyRandom, g_combinedSizes);
+BENCH_ALLOC_DEALLOC_BLUEPRINT(BM_AllocateDeallocateManyRandom, "combined");
 BENCHMARK(BM_AllocateDeallocateManyRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalOpsRangeStart, g_totalOpsRangeEnd)
@@ -2,13 +2,39 @@
 #include "benchmark/benchmark.h"
 #include "benchmark_constants.h"
 #include "benchmark_utils.h"
+#include "fragmentation_metrics.h"
+#include "memory_sampler.h"
+#include "perf_counters.h"
+#include "workload_generator.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <optional>
+#include <string>
 #include <tuple>
+#include <vector>
+
+/**
+ * @brief Flat allocation/deallocation sequence produced by a Worker, stored as struct-of-arrays.
+ * Replaying it needs no random number generation and no state machine.
+ */
+struct OperationStream
+{
+    //! @brief Index inside the active pointers ring, per operation
+    std::vector<uint32_t> slots;
+    //! @brief Allocation size, per operation. 0 means "free the pointer in the slot"
+    std::vector<uint32_t> sizes;
+    //! @brief Size of the active pointers ring
+    uint32_t ringSize = 0;
+    //! @brief Biggest allocation in the stream
+    uint32_t maxSize = 0;
+    //! @brief Results of the recording run (same as Worker::RunBenchmark() returns)
+    std::tuple<uint32_t, uint32_t, uint32_t, int32_t> result;
+};
 
 class Worker
 {
@@ -46,8 +72,8 @@ public:
     Worker(benchmark::State& t_bmState,
            uint32_t t_totalOps = 1024 * 128,
            std::array<std::array<float, 4>, 4> t_transitionMatrix = c_defaultTransitionMatrix,
-           int64_t t_maxMemoryConsumption = (int64_t)1024 * 1024 * 1024 * 2 /* 1024 Mb */,
-           uint64_t t_xorshiftSeed = 0x133796A5FF21B3C1)
+           int64_t t_maxMemoryConsumption = g_complexMaxMemoryConsumption,
+           uint64_t t_xorshiftSeed = g_complexXorshiftSeed)
         : m_bmState(t_bmState)
         , m_activePtrs(20'000, nullptr)
         , m_totalOps(t_totalOps)
@@ -56,16 +82,39 @@ public:
     {
         m_transitionsRngState = bm::utils::XorshiftNext(t_xorshiftSeed);
         m_sizesRngState = bm::utils::XorshiftNext(t_xorshiftSeed);
+        m_burstsRngState = bm::utils::XorshiftNext(t_xorshiftSeed);
+
+        const auto& workload = bm::workload::GetWorkload();
+        m_sizes = workload.sizes ? &*workload.sizes : nullptr;
+        m_allocBursts = workload.allocBursts ? &*workload.allocBursts : nullptr;
+        m_freeBursts = workload.freeBursts ? &*workload.freeBursts : nullptr;
 
         CheckTransitionMatrix();
         CalculateScatters();
     }
 
+    /**
+     * @brief Enables fragmentation sampling at g_complexFragmentationCheckpoints evenly spaced
+     * points of the run. Timing and t_perfCounters are paused while a sample is taken.
+     * @param t_metrics Metrics to update, must outlive the worker
+     * @param t_perfCounters Counters running around RunBenchmark(), if any
+     */
+    void TrackFragmentation(bm::utils::FragmentationMetrics* t_metrics,
+                            bm::utils::PerfCounters* t_perfCounters = nullptr)
+    {
+        m_fragmentation = t_metrics;
+        m_perfCounters = t_perfCounters;
+        m_fragmentationStep = std::max<uint32_t>(m_totalOps / g_complexFragmentationCheckpoints, 1);
+        m_nextFragmentationSample = m_fragmentationStep;
+    }
+
     /**
      * @brief Runs the benchmark.
+     * @tparam Record If true, operations are appended to m_stream instead of calling the allocator
      * @return std::tuple<uint32_t, uint32_t, uint32_t, int32_t> - total number of iterations,
      * number of allocations, number of deallocations, max number of active pointers.
      */
+    template<bool Record = false>
     std::tuple<uint32_t, uint32_t, uint32_t, int32_t> RunBenchmark()
     {
         while (m_allocOps + m_freeOps <= m_totalOps) {
@@ -74,30 +123,53 @@ public:
             switch (op) {
                 case Operation::ALLOC_SINGLE:
                     // std::cout << m_ops << ". Alloc single" << std::endl;
-                    AllocSingle(GetRandomSize());
+                    AllocSingle<Record>(GetRandomSize());
                     break;
                 case Operation::ALLOC_MANY:
                     // std::cout << m_ops << ". Alloc many" << std::endl;
-                    AllocMany(NextMultipleAllocationsCount(),
-                              (bm::utils::XorshiftNext(m_sizesRngState, 0.0f, 1.0f) > 0.8) ? true
-                                                                                           : false);
+                    AllocMany<Record>(NextMultipleAllocationsCount(),
+                                      (bm::utils::XorshiftNext(m_sizesRngState, 0.0f, 1.0f) > 0.8)
+                                          ? true
+                                          : false);
                     break;
                 case Operation::DEALLOC_SINGLE:
                     // std::cout << m_ops << ". Dealloc single" << std::endl;
-                    FreeSingle();
+                    FreeSingle<Record>();
                     break;
                 case Operation::DEALLOC_MANY:
                     // std::cout << m_ops << ". Dealloc many" << std::endl;
-                    FreeMany(NextMultipleDellocationsCount());
+                    FreeMany<Record>(NextMultipleDellocationsCount());
                     break;
                 default:
                     break;
             }
+
+            if (m_fragmentation && m_allocOps + m_freeOps >= m_nextFragmentationSample) {
+                SampleFragmentation();
+                m_nextFragmentationSample += m_fragmentationStep;
+            }
         }
 
         return { m_ops, m_allocOps, m_freeOps, m_maxActivePtrs };
     }
 
+    /**
+     * @brief Runs the state machine without touching the allocator and returns the resulting
+     * allocation/deallocation sequence. Which slot is allocated or freed doesn't depend on the
+     * allocator, so replaying the stream performs exactly the same operations as RunBenchmark().
+     * The worker must not be used afterwards.
+     */
+    OperationStream RecordOperationStream()
+    {
+        m_stream.ringSize = m_activePtrs.size();
+        m_recordedSizes.assign(m_activePtrs.size(), 0);
+        m_stream.result = RunBenchmark<true>();
+
+        // Slots only held markers
+        std::fill(m_activePtrs.begin(), m_activePtrs.end(), nullptr);
+        return std::move(m_stream);
+    }
+
     void CleanUp()
     {
         for (auto& ptr : m_activePtrs) {
@@ -135,6 +207,20 @@ private:
     //! @brief Current memory consumption
     int64_t m_totalAllocated = 0;
 
+    //! @brief Operations recorded by RunBenchmark<true>()
+    OperationStream m_stream;
+    //! @brief Sizes of the chunks in m_activePtrs while recording (they are never allocated)
+    std::vector<int64_t> m_recordedSizes;
+
+    //! @brief Fragmentation metrics to sample (nullptr if disabled)
+    bm::utils::FragmentationMetrics* m_fragmentation = nullptr;
+    //! @brief Perf counters to pause while sampling fragmentation (nullptr if none)
+    bm::utils::PerfCounters* m_perfCounters = nullptr;
+    //! @brief Number of operations between fragmentation samples
+    uint32_t m_fragmentationStep = 0;
+    //! @brief Operation count at which to take the next fragmentation sample
+    uint32_t m_nextFragmentationSample = 0;
+
     //! @brief Alloc scatter factor
     uint32_t m_allocScatter;
 
@@ -145,6 +231,13 @@ private:
     uint64_t m_transitionsRngState;
     //! @brief Random number generator state for sizes generation
     uint64_t m_sizesRngState;
+    //! @brief Random number generator state for configured burst lengths
+    uint64_t m_burstsRngState;
+
+    //! @brief Configured workload distributions, nullptr for the built-in tables @sa bm::workload
+    const bm::workload::Distribution* m_sizes;
+    const bm::workload::Distribution* m_allocBursts;
+    const bm::workload::Distribution* m_freeBursts;
 
     //! @brief Next pointer index inside m_activePtrs to free
     uint32_t m_freeIdx = 0;
@@ -172,6 +265,23 @@ private:
         std::array<float, 4>{ 0.07, 0.00, 0.93, 0.00 }, // DeallocateMultiple
     };
 
+    /**
+     * @brief Takes a fragmentation sample. It reads /proc/self/statm and allocator statistics, so
+     * it's kept out of the measured time and the perf counters.
+     */
+    void SampleFragmentation()
+    {
+        m_bmState.PauseTiming();
+        if (m_perfCounters)
+            m_perfCounters->Stop();
+
+        m_fragmentation->Sample(m_totalAllocated);
+
+        if (m_perfCounters)
+            m_perfCounters->Start();
+        m_bmState.ResumeTiming();
+    }
+
     //! @brief Checks if transition matrix is valid
     void CheckTransitionMatrix()
     {
@@ -221,11 +331,15 @@ private:
      * @brief Gets random size for allocation. If no argument is passed, size is generated randomly.
      * With probability of 0.7 size is generated from g_smallSizes, with probability of 0.2 size is
      * generated from g_mediumSizes, with probability of 0.1 size is generated from g_bigSizes.
+     * A configured size distribution replaces the buckets.
      * @param bucket Bucket to get size from. @sa Sizes
      * @return int64_t Random size
      */
     int64_t GetRandomSize(Sizes bucket = Sizes::INVALID)
     {
+        if (m_sizes && bucket == Sizes::INVALID)
+            return m_sizes->Sample(m_sizesRngState);
+
         if (bucket == Sizes::INVALID) {
             auto rand = bm::utils::XorshiftNext(m_sizesRngState, 0.0f, 1.0f);
             if (rand < 0.7f)
@@ -255,46 +369,67 @@ private:
     }
 
     //! @brief Next number of sequential allocations to perform
-    uint8_t NextMultipleAllocationsCount()
+    uint32_t NextMultipleAllocationsCount()
     {
+        if (m_allocBursts)
+            return m_allocBursts->Sample(m_burstsRngState);
+
         m_allocOpsIdx = (m_allocOpsIdx + m_allocScatter) % g_NumAllocOps.size();
         return m_allocOpsIdx;
     }
 
     //! @brief Next number of sequential deallocations to perform
-    uint8_t NextMultipleDellocationsCount()
+    uint32_t NextMultipleDellocationsCount()
     {
+        if (m_freeBursts)
+            return m_freeBursts->Sample(m_burstsRngState);
+
         m_freeOpsIdx = (m_freeOpsIdx + m_freeScatter) % g_NumFreeOps.size();
         return m_freeOpsIdx;
     }
 
+    //! @brief Frees the chunk in t_slot (or records that) and returns its size.
+    template<bool Record>
+    inline int64_t ReleaseSlot(uint32_t t_slot)
+    {
+        if constexpr (Record) {
+            m_stream.slots.push_back(t_slot);
+            m_stream.sizes.push_back(0);
+            return m_recordedSizes[t_slot];
+        } else {
+            int64_t size = *static_cast<int64_t*>(m_activePtrs[t_slot]);
+            BenchmarkDeallocate(m_activePtrs[t_slot]);
+            return size;
+        }
+    }
+
     /**
      * @brief Allocates single chunk.
      * @param t_size Size of chunk to allocate
      */
+    template<bool Record>
     inline void AllocSingle(int64_t t_size)
     {
         if (m_totalAllocated >= m_maxMemoryConsumption)
             return;
 
         if (m_activePtrs[m_allocIdx]) {
-            m_totalAllocated -= *static_cast<int64_t*>(m_activePtrs[m_allocIdx]);
-            BenchmarkDeallocate(m_activePtrs[m_allocIdx]);
+            m_totalAllocated -= ReleaseSlot<Record>(m_allocIdx);
             m_activePtrs[m_allocIdx] = nullptr;
             ++m_freeOps;
             --m_currActivePtrs;
         }
 
-        m_activePtrs[m_allocIdx] = BenchmarkAllocate(t_size);
-        *static_cast<int64_t*>(m_activePtrs[m_allocIdx]) = t_size;
-
-        // Make sure to write to each page to commit it for measuring memory usage
-        if (t_size) {
-            constexpr std::size_t c_pageSize = 4096;
-            std::size_t num_pages = (t_size - 1) / c_pageSize;
-            for (std::size_t page = 1; page < num_pages; ++page)
-                *((char*)(m_activePtrs[m_allocIdx]) + (page * c_pageSize)) = 1;
-            *((char*)(m_activePtrs[m_allocIdx]) + (t_size - 1)) = 1;
+        if constexpr (Record) {
+            m_stream.slots.push_back(m_allocIdx);
+            m_stream.sizes.push_back(t_size);
+            m_stream.maxSize = std::max<uint32_t>(m_stream.maxSize, t_size);
+            m_recordedSizes[m_allocIdx] = t_size;
+            // Any non-null marker, the slot is never dereferenced
+            m_activePtrs[m_allocIdx] = &m_recordedSizes[m_allocIdx];
+        } else {
+            m_activePtrs[m_allocIdx] = BenchmarkAllocate(t_size);
+            bm::utils::TouchChunk(m_activePtrs[m_allocIdx], t_size);
         }
 
         m_allocIdx = (m_allocIdx + m_allocScatter) % m_activePtrs.size();
@@ -313,6 +448,7 @@ private:
      * @param t_randomSizes If true, sizes are generated per-chunk randomly.
      * Otherwise, all chunks are of the same size.
      */
+    template<bool Record>
     inline void AllocMany(int32_t t_totalChunks, bool t_randomSizes = true)
     {
         if (m_totalAllocated >= m_maxMemoryConsumption)
@@ -324,16 +460,16 @@ private:
             if (t_randomSizes)
                 randomSize = GetRandomSize();
 
-            AllocSingle(randomSize);
+            AllocSingle<Record>(randomSize);
         }
     }
 
     //! @brief Frees single chunk.
+    template<bool Record>
     inline void FreeSingle()
     {
         if (m_activePtrs[m_freeIdx]) {
-            m_totalAllocated -= *static_cast<int64_t*>(m_activePtrs[m_freeIdx]);
-            BenchmarkDeallocate(m_activePtrs[m_freeIdx]);
+            m_totalAllocated -= ReleaseSlot<Record>(m_freeIdx);
             m_activePtrs[m_freeIdx] = nullptr;
             ++m_freeOps;
             --m_currActivePtrs;
@@ -346,17 +482,20 @@ private:
      * @brief Frees multiple chunks.
      * @param t_total Total number of chunks to free.
      */
+    template<bool Record>
     inline void FreeMany(int32_t t_total)
     {
         for (uint32_t i = 0; i < t_total; i++) {
-            FreeSingle();
+            FreeSingle<Record>();
         }
     }
 };
 
 /**
  * @brief Benchmarks the performance of the allocator by performing random (but similar to real
- * program) sequences of  allocations and deallocations
+ * program) sequences of  allocations and deallocations. When registered with ->ThreadRange() each
+ * thread runs its own independent Worker (own seed, own active pointers ring). An optional third
+ * argument overrides the per-worker memory cap (g_complexMaxMemoryConsumption).
  */
 template<class... Args>
 static void BM_Complex(benchmark::State& state, Args&&... args)
@@ -365,18 +504,157 @@ static void BM_Complex(benchmark::State& state, Args&&... args)
     auto totalOps = std::get<0>(argsTuple);
     auto transitionMatrix = std::get<1>(argsTuple);
 
-    std::tuple<uint32_t, uint32_t, uint32_t, uint32_t> result;
+    if (state.threads() > 1 && !BenchmarkAllocatorHas(kBenchmarkCapThreadSafe)) {
+        state.SkipWithError("Allocator is not thread-safe");
+        return;
+    }
+
+    BenchmarkThreadInitialize();
+
+    int64_t maxMemoryConsumption = g_complexMaxMemoryConsumption;
+    if constexpr (sizeof...(Args) > 2)
+        maxMemoryConsumption = std::get<2>(argsTuple);
+    const uint64_t xorshiftSeed = g_complexXorshiftSeed + state.thread_index();
+
+    // RSS is process-wide, a single sampler (owned by thread 0) is enough
+    std::optional<bm::utils::MemorySampler> memorySampler;
+    if (state.thread_index() == 0) {
+        memorySampler.emplace("BM_Complex/" + std::to_string(totalOps) +
+                              "/threads:" + std::to_string(state.threads()));
+        memorySampler->Start();
+    }
+
+    // Live bytes are tracked per worker while RSS is process-wide, so only sample single-threaded
+    bm::utils::FragmentationMetrics fragmentation;
+    const bool trackFragmentation = state.threads() == 1;
+
+    // Counts events of the calling thread only, values are summed over all threads
+    bm::utils::PerfCounters perfCounters;
+
+    std::tuple<uint32_t, uint32_t, uint32_t, uint32_t> result{};
     for (auto _ : state) {
-        Worker worker(state, totalOps, transitionMatrix);
+        Worker worker(state, totalOps, transitionMatrix, maxMemoryConsumption, xorshiftSeed);
+        if (trackFragmentation)
+            worker.TrackFragmentation(&fragmentation, &perfCounters);
+        perfCounters.Start();
         result = worker.RunBenchmark();
+        perfCounters.Stop();
         worker.CleanUp();
     }
 
+    BenchmarkThreadFinalize();
+
+    // Plain counters are summed over all threads
     state.counters["TotalControlLoopIterations"] = std::get<0>(result);
     state.counters["TotalAllocOperations"] = std::get<1>(result);
     state.counters["TotalFreeOperations"] = std::get<2>(result);
-    state.counters["MaxActivePtrs"] = std::get<3>(result);
+    state.counters["MaxActivePtrs"] =
+        benchmark::Counter(std::get<3>(result), benchmark::Counter::kAvgThreads);
+    state.counters["OpsPerSecond"] = benchmark::Counter(
+        static_cast<double>(std::get<1>(result) + std::get<2>(result)) * state.iterations(),
+        benchmark::Counter::kIsRate);
+    state.counters["OpsPerSecondPerThread"] = benchmark::Counter(
+        static_cast<double>(std::get<1>(result) + std::get<2>(result)) * state.iterations(),
+        benchmark::Counter::kIsRate | benchmark::Counter::kAvgThreads);
+    if (memorySampler) {
+        state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+        memorySampler->Stop();
+        memorySampler->Export(state);
+    }
+    if (trackFragmentation)
+        fragmentation.ExportCounters(state);
+    perfCounters.ExportCounters(state);
+}
+
+/**
+ * @brief Replays t_stream into t_ring.
+ * @tparam NullAllocator If true, every allocation returns t_scratch (at least t_stream.maxSize
+ * bytes) and frees do nothing, which leaves only the cost of the replay loop itself.
+ */
+template<bool NullAllocator>
+static void ReplayOperationStream(const OperationStream& t_stream,
+                                  std::vector<void*>& t_ring,
+                                  void* t_scratch = nullptr)
+{
+    const uint32_t* slots = t_stream.slots.data();
+    const uint32_t* sizes = t_stream.sizes.data();
+    const std::size_t totalOps = t_stream.slots.size();
+    for (std::size_t i = 0; i < totalOps; ++i) {
+        void*& ptr = t_ring[slots[i]];
+        if (sizes[i] == 0) {
+            if constexpr (!NullAllocator)
+                BenchmarkDeallocate(ptr);
+            ptr = nullptr;
+        } else {
+            ptr = NullAllocator ? t_scratch : BenchmarkAllocate(sizes[i]);
+            bm::utils::TouchChunk(ptr, sizes[i]);
+        }
+    }
+    benchmark::ClobberMemory();
+}
+
+/**
+ * @brief Same workload as BM_Complex, but the whole operation sequence is generated before timing
+ * starts and then replayed, so the driver's random number generation and state machine aren't
+ * measured. The same stream is also replayed against a null allocator, to report how much of the
+ * time is still spent in the replay loop itself (HarnessNsPerOp, HarnessTimeRatio).
+ */
+static void BM_ComplexReplay(benchmark::State& state,
+                             uint32_t t_totalOps,
+                             std::array<std::array<float, 4>, 4> t_transitionMatrix)
+{
+    BenchmarkThreadInitialize();
+
+    const OperationStream stream =
+        Worker(state, t_totalOps, t_transitionMatrix, g_complexMaxMemoryConsumption)
+            .RecordOperationStream();
+    std::vector<void*> ring(stream.ringSize, nullptr);
+
+    bm::utils::PerfCounters perfCounters;
+    double allocatorTime = 0;
+    for (auto _ : state) {
+        perfCounters.Start();
+        auto start = std::chrono::high_resolution_clock::now();
+        ReplayOperationStream<false>(stream, ring);
+        auto end = std::chrono::high_resolution_clock::now();
+        perfCounters.Stop();
+
+        auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+        state.SetIterationTime(duration.count());
+        allocatorTime += duration.count();
+
+        for (auto& ptr : ring) {
+            if (ptr) {
+                BenchmarkDeallocate(ptr);
+                ptr = nullptr;
+            }
+        }
+    }
+
+    // The scratch chunk is allocated outside of the measured loop
+    void* scratch = BenchmarkAllocate(stream.maxSize);
+    double harnessTime = 0;
+    for (benchmark::IterationCount i = 0; i < state.iterations(); ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        ReplayOperationStream<true>(stream, ring, scratch);
+        auto end = std::chrono::high_resolution_clock::now();
+        harnessTime +=
+            std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+    }
+    BenchmarkDeallocate(scratch);
+
+    BenchmarkThreadFinalize();
+
+    const double totalOps = static_cast<double>(stream.slots.size()) * state.iterations();
+    state.counters["TotalControlLoopIterations"] = std::get<0>(stream.result);
+    state.counters["TotalAllocOperations"] = std::get<1>(stream.result);
+    state.counters["TotalFreeOperations"] = std::get<2>(stream.result);
+    state.counters["MaxActivePtrs"] = std::get<3>(stream.result);
+    state.counters["OpsPerSecond"] = benchmark::Counter(totalOps, benchmark::Counter::kIsRate);
+    state.counters["HarnessNsPerOp"] = harnessTime * 1e9 / totalOps;
+    state.counters["HarnessTimeRatio"] = allocatorTime > 0 ? harnessTime / allocatorTime : 0;
     state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    perfCounters.ExportCounters(state);
 }
 
 #define BENCHMARK_MAT1(iters)                                                                      \
@@ -405,6 +683,27 @@ static void BM_Complex(benchmark::State& state, Args&&... args)
         ->Unit(benchmark::kMillisecond)                                                            \
         ->Iterations(5);
 
+/**
+ * @brief Multi-threaded variant of BENCHMARK_MAT1. Every thread runs the whole workload with a
+ * g_complexMtMaxMemoryConsumption cap (at any thread count), so the scaling efficiency is
+ * OpsPerSecondPerThread(N) / OpsPerSecondPerThread(1).
+ */
+#define BENCHMARK_MAT1_MT(iters)                                                                   \
+    BENCHMARK_CAPTURE(BM_Complex,                                                                  \
+                      "Total ops: " #iters "Transition matrix: ver-1",                             \
+                      (iters),                                                                     \
+                      std::array<std::array<float, 4>, 4>{                                         \
+                          std::array<float, 4>{ 0.2, 0.1, 0.6, 0.1 },   /* AllocateSingle */       \
+                          std::array<float, 4>{ 0.4, 0.1, 0.3, 0.2 },   /* DeallocateSingle */     \
+                          std::array<float, 4>{ 0.1, 0.4, 0.1, 0.4 },   /* AllocateMultiple */     \
+                          std::array<float, 4>{ 0.5, 0.05, 0.4, 0.05 }, /* DeallocateMultiple */   \
+                      },                                                                           \
+                      g_complexMtMaxMemoryConsumption)                                             \
+        ->Unit(benchmark::kMillisecond)                                                            \
+        ->Iterations(5)                                                                            \
+        ->ThreadRange(g_complexThreadsRangeStart, g_complexThreadsRangeEnd)                        \
+        ->UseRealTime()
+
 // BENCHMARK_MAT1()->DenseRange(200'000, 2'000'000, 200'000);
 
 BENCHMARK_MAT1(200'000);
@@ -416,4 +715,25 @@ BENCHMARK_MAT1(1'200'000);
 BENCHMARK_MAT1(1'400'000);
 BENCHMARK_MAT1(1'600'000);
 BENCHMARK_MAT1(1'800'000);
-BENCHMARK_MAT1(2'000'000);
\ No newline at end of file
+BENCHMARK_MAT1(2'000'000);
+
+BENCHMARK_MAT1_MT(200'000);
+BENCHMARK_MAT1_MT(1'000'000);
+
+#define BENCHMARK_MAT1_REPLAY(iters)                                                               \
+    BENCHMARK_CAPTURE(BM_ComplexReplay,                                                            \
+                      "Total ops: " #iters "Transition matrix: ver-1",                             \
+                      (iters),                                                                     \
+                      std::array<std::array<float, 4>, 4>{                                         \
+                          std::array<float, 4>{ 0.2, 0.1, 0.6, 0.1 },   /* AllocateSingle */       \
+                          std::array<float, 4>{ 0.4, 0.1, 0.3, 0.2 },   /* DeallocateSingle */     \
+                          std::array<float, 4>{ 0.1, 0.4, 0.1, 0.4 },   /* AllocateMultiple */     \
+                          std::array<float, 4>{ 0.5, 0.05, 0.4, 0.05 }, /* DeallocateMultiple */   \
+                      })                                                                           \
+        ->Unit(benchmark::kMillisecond)                                                            \
+        ->Iterations(5)                                                                            \
+        ->UseManualTime()
+
+BENCHMARK_MAT1_REPLAY(200'000);
+BENCHMARK_MAT1_REPLAY(1'000'000);
+BENCHMARK_MAT1_REPLAY(2'000'000);
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <array>
 #include <cstdint>
 
@@ -16,6 +18,87 @@ constexpr uint32_t g_totalOpsRangeEnd{ 4 << 11 };
 constexpr uint32_t g_accessMemoryRangeStart{ 64 };
 constexpr uint32_t g_accessMemoryRangeEnd{ 2 << 10 };
 
+constexpr int32_t g_complexThreadsRangeStart{ 1 };
+constexpr int32_t g_complexThreadsRangeEnd{ 32 };
+
+// 2 Gb for the worker of a single-threaded run
+constexpr int64_t g_complexMaxMemoryConsumption{ (int64_t)1024 * 1024 * 1024 * 2 };
+// Per worker of the multi-threaded runs: the same 2 Gb split for the largest thread count, so that
+// every thread count runs the same per-worker workload and the total stays within 2 Gb
+constexpr int64_t g_complexMtMaxMemoryConsumption{ g_complexMaxMemoryConsumption /
+                                                   g_complexThreadsRangeEnd };
+constexpr uint64_t g_complexXorshiftSeed{ 0x133796A5FF21B3C1 };
+// Fragmentation samples taken during a single (single-threaded) BM_Complex run
+constexpr uint32_t g_complexFragmentationCheckpoints{ 16 };
+
+constexpr uint32_t g_crossThreadFreeTotalChunks{ 64 << 10 };
+constexpr uint32_t g_crossThreadFreeQueueCapacity{ 4 << 10 };
+constexpr uint64_t g_crossThreadFreeXorshiftSeed{ 0x133796A5FF21B3C2 };
+
+constexpr uint32_t g_vectorGrowthInitialSize{ 16 };
+// Share of buffers shrunk after reaching their final size, and by how much
+constexpr float g_vectorGrowthShrinkProbability{ 0.25 };
+constexpr uint32_t g_vectorGrowthShrinkFactor{ 4 };
+constexpr uint64_t g_vectorGrowthXorshiftSeed{ 0x133796A5FF21B3C3 };
+
+// Multi-mutator GC graph (memplusplus). Ops are per mutator, vertices are split between mutators
+constexpr uint32_t g_gcMutatorTotalOps{ 50'000 };
+constexpr uint32_t g_gcSharedRegionVertices{ 1 << 10 };
+// Probability of an edge crossing into (or out of) the shared region on CREATE_EDGE
+constexpr float g_gcCrossClusterEdgeRatio{ 0.05 };
+constexpr uint64_t g_gcXorshiftSeed{ 0x133796A5FF21B3C7 };
+
+// Pointer-based structures traversal (trees, hash table, DAG)
+constexpr uint32_t g_traversalNodesRangeStart{ 1 << 10 };
+constexpr uint32_t g_traversalNodesRangeEnd{ 1 << 18 };
+constexpr uint32_t g_traversalHashChainLength{ 4 };
+constexpr uint32_t g_traversalDagLayerWidth{ 64 };
+constexpr uint64_t g_traversalXorshiftSeed{ 0x133796A5FF21B3C8 };
+
+// Memory return after a heap was freed. RSS is sampled every interval for the window
+// (MPP_BENCH_DECAY_WINDOW_MS), memory counts as released once at most the given ratio of the RSS
+// growth is left
+constexpr uint32_t g_memoryReturnDecayWindowMs{ 1000 };
+constexpr uint32_t g_memoryReturnSampleIntervalMs{ 5 };
+constexpr double g_memoryReturnReleasedRatio{ 0.1 };
+constexpr uint64_t g_memoryReturnXorshiftSeed{ 0x133796A5FF21B3C9 };
+
+// Size class sweep: chunks allocated per size, and the size grid step below 1 KiB, 8 KiB and above
+constexpr uint32_t g_sizeClassBatch{ 256 };
+constexpr uint32_t g_sizeClassGridStepSmall{ 8 };
+constexpr uint32_t g_sizeClassGridStepMedium{ 64 };
+constexpr uint32_t g_sizeClassGridStepBig{ 512 };
+
+// Lifetime-aware workload. Lifetimes are counted in allocations, specs are bm::workload ones and
+// can be overridden with --workload_sizes/--workload_request_lifetimes/--workload_session_lifetimes
+constexpr const char* g_lifetimeSizes{ "mix:0.8@builtin:small|0.2@builtin:medium" };
+constexpr const char* g_lifetimeRequestLifetimes{ "lognormal:32,1.0,1,4096" };
+constexpr const char* g_lifetimeSessionLifetimes{ "lognormal:65536,0.7,4096,1048576" };
+// Probability of the request, session and immortal generation for small [16, 4096), medium
+// [4096, 65536) and big sizes
+constexpr std::array<std::array<float, 3>, 3> g_lifetimeGenerationMix{
+    std::array<float, 3>{ 0.90, 0.09, 0.01 },
+    std::array<float, 3>{ 0.75, 0.23, 0.02 },
+    std::array<float, 3>{ 0.55, 0.43, 0.02 },
+};
+constexpr uint32_t g_lifetimeFragmentationCheckpoints{ 16 };
+constexpr uint64_t g_lifetimeXorshiftSeed{ 0x133796A5FF21B3CA };
+
+// Thread churn: waves of short-lived threads per iteration. Every thread keeps a ring of live
+// chunks and leaves some of them to its parent, which frees them after the thread exited
+constexpr uint32_t g_threadChurnWaves{ 32 };
+constexpr uint32_t g_threadChurnLiveChunks{ 64 };
+constexpr uint32_t g_threadChurnHandoffChunks{ 16 };
+constexpr uint64_t g_threadChurnXorshiftSeed{ 0x133796A5FF21B3CB };
+
+// NUMA locality: list nodes per worker (64 byte nodes) and pages queried per move_pages() call
+constexpr uint32_t g_numaListNodesRangeStart{ 1 << 16 };
+constexpr uint32_t g_numaListNodesRangeEnd{ 1 << 20 };
+constexpr uint32_t g_numaPagesPerQuery{ 4096 };
+//! @brief Walked before every timed traversal, bigger than the last level cache of current CPUs
+constexpr uint32_t g_numaCacheEvictBytes{ 128 << 20 };
+constexpr uint64_t g_numaXorshiftSeed{ 0x133796A5FF21B3CC };
+
 static constexpr std::array<int32_t, 256> g_Primes = { 7,   11,  13,  17,  19,  23,  29,  31,  37,
                                                        41,  43,  47,  53,  59,  61,  67,  71,  73,
                                                        79,  83,  89,  97,  101, 103, 107, 109, 113,
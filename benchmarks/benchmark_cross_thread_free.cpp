@@ -0,0 +1,137 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "latency_histogram.h"
+#include "memory_sampler.h"
+#include "mpmc_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Benchmarks the remote-free path: producer threads allocate chunks and pass them through a
+ * lock-free queue to consumer threads, which deallocate them. Time is measured from the moment all
+ * threads are spawned until every chunk is freed.
+ */
+static void BM_CrossThreadFree(benchmark::State& state)
+{
+    const uint32_t totalProducers = state.range(0);
+    const uint32_t totalConsumers = state.range(1);
+
+    if (!BenchmarkAllocatorHas(kBenchmarkCapThreadSafe)) {
+        state.SkipWithError("Allocator is not thread-safe");
+        return;
+    }
+
+    // Precompute allocation sizes, so that RNG doesn't end up in the timed region
+    const uint32_t chunksPerProducer = g_crossThreadFreeTotalChunks / totalProducers;
+    const uint32_t totalChunks = chunksPerProducer * totalProducers;
+    std::vector<std::vector<uint32_t>> sizes(totalProducers);
+    for (uint32_t producer = 0; producer < totalProducers; ++producer) {
+        uint64_t rngState = g_crossThreadFreeXorshiftSeed + producer;
+        sizes[producer].reserve(chunksPerProducer);
+        for (uint32_t i = 0; i < chunksPerProducer; ++i) {
+            sizes[producer].push_back(g_combinedSizes[bm::utils::XorshiftNext(
+                rngState, 0, g_combinedSizes.size() - 1)]);
+        }
+    }
+
+    // Per-consumer remote free latencies over all iterations
+    std::vector<bm::utils::LatencyHistogram> freeLatencies(totalConsumers);
+
+    bm::utils::MemorySampler memorySampler("BM_CrossThreadFree/" +
+                                           std::to_string(totalProducers) + "/" +
+                                           std::to_string(totalConsumers));
+    memorySampler.Start();
+    for (auto _ : state) {
+        bm::utils::MpmcQueue<void*> queue(g_crossThreadFreeQueueCapacity);
+        std::atomic<uint32_t> threadsReady{ 0 };
+        std::atomic<bool> start{ false };
+        std::atomic<uint32_t> chunksFreed{ 0 };
+
+        auto waitForStart = [&]() {
+            threadsReady.fetch_add(1, std::memory_order_acq_rel);
+            while (!start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(totalProducers + totalConsumers);
+
+        for (uint32_t producer = 0; producer < totalProducers; ++producer) {
+            threads.emplace_back([&, producer]() {
+                BenchmarkThreadInitialize();
+                waitForStart();
+                for (uint32_t size : sizes[producer]) {
+                    void* ptr = BenchmarkAllocate(size);
+                    *static_cast<char*>(ptr) = 1;
+                    while (!queue.TryPush(ptr))
+                        std::this_thread::yield();
+                }
+                BenchmarkThreadFinalize();
+            });
+        }
+
+        for (uint32_t consumer = 0; consumer < totalConsumers; ++consumer) {
+            threads.emplace_back([&, consumer]() {
+                auto& latencies = freeLatencies[consumer];
+                BenchmarkThreadInitialize();
+                waitForStart();
+                void* ptr = nullptr;
+                while (chunksFreed.load(std::memory_order_relaxed) < totalChunks) {
+                    if (!queue.TryPop(ptr)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    uint64_t freeStart = bm::utils::ReadTimestamp();
+                    BenchmarkDeallocate(ptr);
+                    latencies.Record(bm::utils::ReadTimestamp() - freeStart);
+                    chunksFreed.fetch_add(1, std::memory_order_relaxed);
+                }
+                BenchmarkThreadFinalize();
+            });
+        }
+
+        while (threadsReady.load(std::memory_order_acquire) != threads.size())
+            std::this_thread::yield();
+
+        auto begin = std::chrono::high_resolution_clock::now();
+        start.store(true, std::memory_order_release);
+        for (auto& thread : threads)
+            thread.join();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        state.SetIterationTime(
+            std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count());
+    }
+    memorySampler.Stop();
+
+    bm::utils::LatencyHistogram allLatencies;
+    for (auto& latencies : freeLatencies)
+        allLatencies.Merge(latencies);
+
+    state.counters["ChunksPerSecond"] = benchmark::Counter(
+        static_cast<double>(totalChunks) * state.iterations(), benchmark::Counter::kIsRate);
+    allLatencies.ExportCounters(state, "RemoteFree");
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    memorySampler.Export(state);
+}
+
+BENCHMARK(BM_CrossThreadFree)
+    ->ArgNames({ "producers", "consumers" })
+    ->Args({ 1, 1 })
+    ->Args({ 1, 2 })
+    ->Args({ 1, 4 })
+    ->Args({ 2, 1 })
+    ->Args({ 4, 1 })
+    ->Args({ 2, 2 })
+    ->Args({ 4, 4 })
+    ->Args({ 8, 8 })
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
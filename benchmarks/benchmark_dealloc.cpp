@@ -2,58 +2,95 @@
 #include "benchmark/benchmark.h"
 #include "benchmark_constants.h"
 #include "benchmark_utils.h"
+#include "workload_generator.h"
+#include "latency_histogram.h"
 
-#define BENCH_DEALLOC_BLUEPRINT(BM_NAME, sizes)                                                    \
+#include <chrono>
+#include <vector>
+
+/**
+ * @brief If sized, chunks are freed with BenchmarkDeallocateSized() and their request size. The
+ * label tells whether the allocator uses the size or falls back to BenchmarkDeallocate().
+ */
+#define BENCH_DEALLOC_BLUEPRINT(BM_NAME, sizes, sized)                                             \
     static void BM_NAME(benchmark::State& state)                                                   \
     {                                                                                              \
+        bm::utils::LatencyHistogram freeLatency;                                                   \
+        const auto requestSizes = bm::utils::PrecomputeSizes(                                      \
+            bm::workload::GetSizes(sizes), state.range(0), 1337 + 2);                              \
+        std::vector<void*> pointers(state.range(0));                                               \
         for (auto _ : state) {                                                                     \
-            state.PauseTiming();                                                                   \
-            bm::utils::XorshiftInit(1337 + 2);                                                     \
-            std::vector<void*> pointers;                                                           \
-            pointers.reserve(state.range(0));                                                      \
-            for (uint32_t iter = 0; iter < state.range(0); ++iter) {                               \
-                pointers.emplace_back(                                                             \
-                    BenchmarkAllocate(sizes[bm::utils::XorshiftNext() % sizes.size()]));           \
+            for (std::size_t iter = 0; iter < requestSizes.size(); ++iter)                         \
+                pointers[iter] = BenchmarkAllocate(requestSizes[iter]);                            \
+            auto start = std::chrono::high_resolution_clock::now();                                \
+            for (std::size_t iter = 0; iter < pointers.size(); ++iter) {                           \
+                if (sized) {                                                                       \
+                    bm::utils::InstrumentedDeallocateSized(                                        \
+                        freeLatency, pointers[iter], requestSizes[iter]);                          \
+                } else {                                                                           \
+                    bm::utils::InstrumentedDeallocate(freeLatency, pointers[iter]);                \
+                }                                                                                  \
             }                                                                                      \
-            state.ResumeTiming();                                                                  \
-            for (auto ptr : pointers)                                                              \
-                BenchmarkDeallocate(ptr);                                                          \
+            auto end = std::chrono::high_resolution_clock::now();                                  \
+            state.SetIterationTime(                                                                \
+                std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());   \
         }                                                                                          \
+        if (sized) {                                                                               \
+            state.SetLabel(BenchmarkAllocatorHas(kBenchmarkCapNativeDeallocateSized)               \
+                               ? "native-sized-free"                                               \
+                               : "fallback-sized-free");                                           \
+        }                                                                                          \
+        bm::utils::ExportInstrumentedLatency(state, freeLatency, "FreeLatency");                   \
     }
 
 /**
  * @brief Benchmarks the deallocation speed for many different small sizes.
  */
-BENCH_DEALLOC_BLUEPRINT(DISABLED_BM_DeallocateManySmallRandom, g_smallSizes)
+BENCH_DEALLOC_BLUEPRINT(DISABLED_BM_DeallocateManySmallRandom, "small", false)
 BENCHMARK(DISABLED_BM_DeallocateManySmallRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalDeallocOpsRangeStart, g_totalDeallocOpsRangeEnd)
-    ->Unit(benchmark::kMicrosecond);
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
 
 /**
  * @brief Benchmarks the deallocation speed for many different medium sizes.
  */
-BENCH_DEALLOC_BLUEPRINT(DISABLED_BM_DeallocateManyMediumRandom, g_mediumSizes)
+BENCH_DEALLOC_BLUEPRINT(DISABLED_BM_DeallocateManyMediumRandom, "medium", false)
 BENCHMARK(DISABLED_BM_DeallocateManyMediumRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalDeallocOpsRangeStart, g_totalDeallocOpsRangeEnd)
-    ->Unit(benchmark::kMicrosecond);
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
 
 /**
  * @brief Benchmarks the deallocation speed for many different big sizes.
  */
-BENCH_DEALLOC_BLUEPRINT(DISABLED_BM_DeallocateManyBigRandom, g_bigSizes)
+BENCH_DEALLOC_BLUEPRINT(DISABLED_BM_DeallocateManyBigRandom, "big", false)
 BENCHMARK(DISABLED_BM_DeallocateManyBigRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalDeallocOpsRangeStart, g_totalDeallocOpsRangeEnd)
-    ->Unit(benchmark::kMicrosecond);
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
 
 /**
  * @brief Benchmarks the deallocation speed for many differently sized objects (including small,
  * medium and big sizes).
  */
-BENCH_DEALLOC_BLUEPRINT(BM_DeallocateManyRandom, g_combinedSizes)
+BENCH_DEALLOC_BLUEPRINT(BM_DeallocateManyRandom, "combined", false)
 BENCHMARK(BM_DeallocateManyRandom)
     ->RangeMultiplier(2)
     ->Range(g_totalDeallocOpsRangeStart, g_totalDeallocOpsRangeEnd)
-    ->Unit(benchmark::kMicrosecond);
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
+
+/**
+ * @brief BM_DeallocateManyRandom with sized deallocation (BenchmarkDeallocateSized()), to compare
+ * with the unsized free of the same chunks.
+ */
+BENCH_DEALLOC_BLUEPRINT(BM_DeallocateManyRandomSized, "combined", true)
+BENCHMARK(BM_DeallocateManyRandomSized)
+    ->RangeMultiplier(2)
+    ->Range(g_totalDeallocOpsRangeStart, g_totalDeallocOpsRangeEnd)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
@@ -0,0 +1,300 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "fragmentation_metrics.h"
+#include "latency_histogram.h"
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    //! @brief Object generations, by how long objects live.
+    enum class Generation : uint8_t
+    {
+        REQUEST = 0,
+        SESSION,
+        IMMORTAL,
+        COUNT
+    };
+
+    constexpr std::size_t c_generations = static_cast<std::size_t>(Generation::COUNT);
+    constexpr std::array<const char*, c_generations> c_generationNames = { "Request",
+                                                                           "Session",
+                                                                           "Immortal" };
+
+    /**
+     * @brief Allocation/deallocation sequence of a lifetime workload, generated before timing
+     * starts (like BM_ComplexReplay's OperationStream).
+     */
+    struct LifetimeStream
+    {
+        //! @brief Index inside the live chunks ring, per operation
+        std::vector<uint32_t> slots;
+        //! @brief Allocation size, per operation. 0 means "free the chunk in the slot"
+        std::vector<uint32_t> sizes;
+        //! @brief Generation of the allocated or freed chunk, per operation
+        std::vector<Generation> generations;
+        //! @brief Size of the live chunks ring
+        uint32_t ringSize = 0;
+        //! @brief Slots still live at the end of the stream, per generation
+        std::array<std::vector<uint32_t>, c_generations> liveSlots;
+        std::array<uint64_t, c_generations> allocs{};
+    };
+
+    //! @brief Index of t_size in the rows of g_lifetimeGenerationMix
+    inline std::size_t GetSizeClass(uint32_t t_size)
+    {
+        if (t_size < 4096)
+            return 0;
+        if (t_size < 65536)
+            return 1;
+        return 2;
+    }
+
+    /**
+     * @brief Generates t_totalAllocs allocations. Every allocation picks a size, then a generation
+     * from the size's row of g_lifetimeGenerationMix and a lifetime from the generation's
+     * distribution. The clock advances by one per allocation, chunks are freed (before the next
+     * allocation) once their lifetime is over. Immortal chunks are never freed in the stream.
+     */
+    LifetimeStream GenerateLifetimeStream(uint32_t t_totalAllocs)
+    {
+        const auto& workload = bm::workload::GetWorkload();
+        // TouchChunk() stores the size in the first bytes of every chunk
+        const auto sizes = workload.sizes ? *workload.sizes
+                                          : bm::workload::Distribution::Parse(g_lifetimeSizes,
+                                                                              sizeof(int64_t));
+        const auto requestLifetimes =
+            workload.requestLifetimes
+                ? *workload.requestLifetimes
+                : bm::workload::Distribution::Parse(g_lifetimeRequestLifetimes, 1);
+        const auto sessionLifetimes =
+            workload.sessionLifetimes
+                ? *workload.sessionLifetimes
+                : bm::workload::Distribution::Parse(g_lifetimeSessionLifetimes, 1);
+
+        LifetimeStream stream;
+        stream.slots.reserve(2 * t_totalAllocs);
+        stream.sizes.reserve(2 * t_totalAllocs);
+        stream.generations.reserve(2 * t_totalAllocs);
+
+        // (death time, slot) of every mortal live chunk, earliest first
+        using Death = std::pair<uint64_t, uint32_t>;
+        std::priority_queue<Death, std::vector<Death>, std::greater<Death>> deaths;
+        std::vector<Generation> slotGenerations;
+        std::vector<uint32_t> vacantSlots;
+
+        uint64_t rngState = g_lifetimeXorshiftSeed;
+        for (uint64_t now = 0; now < t_totalAllocs; ++now) {
+            while (!deaths.empty() && deaths.top().first <= now) {
+                uint32_t slot = deaths.top().second;
+                deaths.pop();
+                stream.slots.push_back(slot);
+                stream.sizes.push_back(0);
+                stream.generations.push_back(slotGenerations[slot]);
+                vacantSlots.push_back(slot);
+            }
+
+            const uint32_t size = sizes.Sample(rngState);
+            const auto& mix = g_lifetimeGenerationMix[GetSizeClass(size)];
+            const float rand = bm::utils::XorshiftNext(rngState, 0.0f, 1.0f);
+            Generation generation = Generation::IMMORTAL;
+            if (rand < mix[0])
+                generation = Generation::REQUEST;
+            else if (rand < mix[0] + mix[1])
+                generation = Generation::SESSION;
+
+            uint32_t slot;
+            if (!vacantSlots.empty()) {
+                slot = vacantSlots.back();
+                vacantSlots.pop_back();
+                slotGenerations[slot] = generation;
+            } else {
+                slot = slotGenerations.size();
+                slotGenerations.push_back(generation);
+            }
+
+            if (generation == Generation::REQUEST)
+                deaths.emplace(now + requestLifetimes.Sample(rngState), slot);
+            else if (generation == Generation::SESSION)
+                deaths.emplace(now + sessionLifetimes.Sample(rngState), slot);
+
+            stream.slots.push_back(slot);
+            stream.sizes.push_back(size);
+            stream.generations.push_back(generation);
+            ++stream.allocs[static_cast<std::size_t>(generation)];
+        }
+
+        stream.ringSize = slotGenerations.size();
+        std::vector<bool> vacant(stream.ringSize, false);
+        for (uint32_t slot : vacantSlots)
+            vacant[slot] = true;
+        for (uint32_t slot = 0; slot < stream.ringSize; ++slot) {
+            if (!vacant[slot])
+                stream.liveSlots[static_cast<std::size_t>(slotGenerations[slot])].push_back(slot);
+        }
+
+        return stream;
+    }
+
+    /**
+     * @brief Frees the live chunks of t_generation, lets the allocator release what it can and
+     * returns the RSS growth over t_rssBefore.
+     */
+    std::size_t DrainGeneration(const LifetimeStream& t_stream,
+                                Generation t_generation,
+                                std::vector<void*>& t_ring,
+                                std::size_t t_rssBefore)
+    {
+        for (uint32_t slot : t_stream.liveSlots[static_cast<std::size_t>(t_generation)]) {
+            BenchmarkDeallocate(t_ring[slot]);
+            t_ring[slot] = nullptr;
+        }
+
+        BenchmarkAllocatorPurge();
+        std::size_t rss = bm::utils::GetProcCurrentMemoryUsage();
+        return rss > t_rssBefore ? rss - t_rssBefore : 0;
+    }
+}
+
+/**
+ * @brief Lifetime-aware workload: a mass of short-lived request-scoped objects, session-scoped
+ * objects that survive many requests and a small immortal set, mixed per size class
+ * (g_lifetimeGenerationMix). range(0) allocations are generated before timing starts and then
+ * replayed, every operation timed with ReadTimestamp(), so time and throughput are reported per
+ * generation (<Generation>OpsPerSecond, <Generation>AllocNs, <Generation>FreeNs).
+ *
+ * Fragmentation is sampled during the replay (LiveToRss) and at the end per generation: request
+ * chunks are freed and the allocator purged, then LongLivedToRss compares the live session and
+ * immortal bytes with the RSS growth since the benchmark started. The same is repeated for
+ * session chunks (ImmortalToRss). Ratios below 1 show memory pinned by long-lived chunks scattered
+ * between freed ones. The RSS baseline is taken once, after a purge, like in BM_MemoryReturn. An
+ * iteration whose RSS growth is smaller than the live bytes (the chunks sit in memory an earlier
+ * benchmark left to the allocator) can't be measured: it is counted in UnmeasuredIterations and
+ * left out of both ratios (MPP_BENCH_ISOLATE avoids such iterations).
+ */
+static void BM_Lifetimes(benchmark::State& state)
+{
+    const LifetimeStream stream = GenerateLifetimeStream(state.range(0));
+    std::vector<void*> ring(stream.ringSize, nullptr);
+    std::vector<uint32_t> ringSizes(stream.ringSize, 0);
+
+    const std::size_t totalOps = stream.slots.size();
+    const std::size_t checkpointStep =
+        std::max<std::size_t>(totalOps / g_lifetimeFragmentationCheckpoints, 1);
+    bm::utils::FragmentationMetrics fragmentation;
+
+    std::array<uint64_t, c_generations> allocTicks{};
+    std::array<uint64_t, c_generations> freeTicks{};
+    std::array<uint64_t, c_generations> frees{};
+    std::array<std::size_t, c_generations> liveBytesPeak{};
+    double longLivedToRssSum = 0;
+    double immortalToRssSum = 0;
+    uint64_t measuredIterations = 0;
+    bool purgeSupported = false;
+
+    // Taken once, memory the allocator kept from previous iterations counts as held
+    BenchmarkAllocatorPurge();
+    const std::size_t rssBefore = bm::utils::GetProcCurrentMemoryUsage();
+    for (auto _ : state) {
+        std::array<std::size_t, c_generations> liveBytes{};
+        uint64_t iterationTicks = 0;
+
+        for (std::size_t i = 0; i < totalOps; ++i) {
+            const uint32_t slot = stream.slots[i];
+            const uint32_t size = stream.sizes[i];
+            const std::size_t generation = static_cast<std::size_t>(stream.generations[i]);
+
+            if (size == 0) {
+                uint64_t start = bm::utils::ReadTimestamp();
+                BenchmarkDeallocate(ring[slot]);
+                uint64_t ticks = bm::utils::ReadTimestamp() - start;
+                freeTicks[generation] += ticks;
+                iterationTicks += ticks;
+                ++frees[generation];
+                liveBytes[generation] -= ringSizes[slot];
+                ring[slot] = nullptr;
+            } else {
+                uint64_t start = bm::utils::ReadTimestamp();
+                ring[slot] = BenchmarkAllocate(size);
+                uint64_t ticks = bm::utils::ReadTimestamp() - start;
+                allocTicks[generation] += ticks;
+                iterationTicks += ticks;
+                bm::utils::TouchChunk(ring[slot], size);
+                ringSizes[slot] = size;
+                liveBytes[generation] += size;
+                liveBytesPeak[generation] =
+                    std::max(liveBytesPeak[generation], liveBytes[generation]);
+            }
+
+            if ((i + 1) % checkpointStep == 0)
+                fragmentation.Sample(liveBytes[0] + liveBytes[1] + liveBytes[2]);
+        }
+
+        state.SetIterationTime(iterationTicks / bm::utils::GetTimestampTicksPerNs() / 1e9);
+
+        // Youngest generation first, the way a request/session server would shed them
+        const std::size_t longLivedBytes = liveBytes[1] + liveBytes[2];
+        std::size_t longLivedGrowth =
+            DrainGeneration(stream, Generation::REQUEST, ring, rssBefore);
+        std::size_t immortalGrowth = DrainGeneration(stream, Generation::SESSION, ring, rssBefore);
+        DrainGeneration(stream, Generation::IMMORTAL, ring, rssBefore);
+        // Live chunks can't take less RSS than their size, unless they sit in memory the
+        // allocator had before the baseline
+        if (longLivedGrowth >= longLivedBytes && immortalGrowth >= liveBytes[2] &&
+            longLivedGrowth > 0) {
+            ++measuredIterations;
+            longLivedToRssSum += static_cast<double>(longLivedBytes) / longLivedGrowth;
+            immortalToRssSum +=
+                immortalGrowth ? static_cast<double>(liveBytes[2]) / immortalGrowth : 0;
+        }
+        purgeSupported = BenchmarkAllocatorPurge();
+    }
+
+    const double iterations = static_cast<double>(state.iterations());
+    const double ticksPerNs = bm::utils::GetTimestampTicksPerNs();
+    uint64_t totalTicks = 0;
+    for (std::size_t generation = 0; generation < c_generations; ++generation) {
+        const std::string name = c_generationNames[generation];
+        const double allocs = static_cast<double>(stream.allocs[generation]) * iterations;
+        const double ticks = static_cast<double>(allocTicks[generation] + freeTicks[generation]);
+        totalTicks += allocTicks[generation] + freeTicks[generation];
+
+        state.counters[name + "Allocs"] = stream.allocs[generation];
+        state.counters[name + "OpsPerSecond"] =
+            ticks > 0 ? (allocs + frees[generation]) / (ticks / ticksPerNs / 1e9) : 0;
+        state.counters[name + "AllocNs"] =
+            allocs > 0 ? allocTicks[generation] / ticksPerNs / allocs : 0;
+        state.counters[name + "FreeNs"] =
+            frees[generation] ? freeTicks[generation] / ticksPerNs / frees[generation] : 0;
+        state.counters[name + "LiveBytesPeak"] = liveBytesPeak[generation];
+    }
+
+    state.SetLabel(purgeSupported ? "purge" : "no-purge");
+    state.counters["OpsPerSecond"] =
+        totalTicks ? totalOps * iterations / (totalTicks / ticksPerNs / 1e9) : 0;
+    if (measuredIterations > 0) {
+        state.counters["LongLivedToRss"] = longLivedToRssSum / measuredIterations;
+        state.counters["ImmortalToRss"] = immortalToRssSum / measuredIterations;
+    }
+    state.counters["UnmeasuredIterations"] = state.iterations() - measuredIterations;
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    fragmentation.ExportCounters(state);
+}
+
+BENCHMARK(BM_Lifetimes)
+    ->ArgNames({ "allocs" })
+    ->Arg(256 << 10)
+    ->Arg(1 << 20)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
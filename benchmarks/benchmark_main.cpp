@@ -1,12 +1,38 @@
 #include "benchmark/benchmark.h"
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
+#include "isolated_runner.h"
+#include "workload_generator.h"
+
+#include <cstring>
+#include <iostream>
 
 int main(int argc, char** argv)
 {
-    BenchmarkAllocatorInitialize();
+    // Used by run_profile_sweep.sh to find out which profiles to run
+    if (argc > 1 && std::strcmp(argv[1], "--list_profiles") == 0) {
+        for (const char* const* profile = BenchmarkAllocatorProfiles(); *profile; ++profile)
+            std::cout << *profile << std::endl;
+        return 0;
+    }
+
+    // Children of an isolated run come back here with MPP_BENCH_ISOLATE unset
+    auto isolationMode = bm::utils::GetIsolationMode();
+    if (isolationMode != bm::utils::IsolationMode::NONE)
+        return bm::utils::RunIsolated(argc, argv, isolationMode);
+
+    const char* profile = bm::profiles::GetSelectedProfile();
+    if (!BenchmarkAllocatorInitialize(profile)) {
+        std::cerr << "Failed to initialize the allocator with profile " << profile << std::endl;
+        return 1;
+    }
+    ::benchmark::AddCustomContext("allocator_profile", profile);
+
+    if (!bm::workload::ParseArguments(argc, argv))
+        return 1;
 
     ::benchmark::Initialize(&argc, argv);
     ::benchmark::RunSpecifiedBenchmarks();
 
     BenchmarkAllocatorFinalize();
-}
\ No newline at end of file
+}
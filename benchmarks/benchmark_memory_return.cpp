@@ -0,0 +1,175 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "memory_sampler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    /**
+     * @brief Builds a heap of t_heapBytes live bytes: batches of allocations from t_sizes
+     * interleaved with batches of frees of random live chunks (half of BM_Complex's free batch
+     * sizes, so that the heap grows). Every chunk is written completely, so that it is resident.
+     */
+    template<class Sizes>
+    void BuildHeap(std::vector<std::pair<void*, std::size_t>>& t_live,
+                   const Sizes& t_sizes,
+                   std::size_t t_heapBytes,
+                   uint64_t& t_rngState)
+    {
+        std::size_t liveBytes = 0;
+        while (liveBytes < t_heapBytes) {
+            uint32_t allocs =
+                g_NumAllocOps[bm::utils::XorshiftNext(t_rngState) % g_NumAllocOps.size()];
+            for (uint32_t i = 0; i < allocs; ++i) {
+                std::size_t size = t_sizes[bm::utils::XorshiftNext(t_rngState) % t_sizes.size()];
+                void* ptr = BenchmarkAllocate(size);
+                std::memset(ptr, 0xAB, size);
+                t_live.emplace_back(ptr, size);
+                liveBytes += size;
+            }
+
+            uint32_t frees =
+                g_NumFreeOps[bm::utils::XorshiftNext(t_rngState) % g_NumFreeOps.size()] / 2;
+            for (uint32_t i = 0; i < frees && !t_live.empty(); ++i) {
+                std::size_t idx = bm::utils::XorshiftNext(t_rngState) % t_live.size();
+                BenchmarkDeallocate(t_live[idx].first);
+                liveBytes -= t_live[idx].second;
+                t_live[idx] = t_live.back();
+                t_live.pop_back();
+            }
+        }
+    }
+
+    //! @brief How long RSS is watched after everything was freed (MPP_BENCH_DECAY_WINDOW_MS)
+    std::chrono::milliseconds GetDecayWindow()
+    {
+        const char* window = std::getenv("MPP_BENCH_DECAY_WINDOW_MS");
+        return std::chrono::milliseconds(window ? std::strtoull(window, nullptr, 10)
+                                                : g_memoryReturnDecayWindowMs);
+    }
+}
+
+/**
+ * @brief Measures whether (and how fast) the allocator returns memory to the OS once a heap is
+ * freed. Every iteration builds a heap of range(0) MiB with BM_Complex-style traffic (range(1)
+ * selects small, medium or combined sizes), frees all of it and then samples RSS, without
+ * touching the allocator, for MPP_BENCH_DECAY_WINDOW_MS. Finally BenchmarkAllocatorPurge() asks
+ * the allocator to release what it still holds.
+ *
+ * The iteration time is the time until RSS dropped to g_memoryReturnReleasedRatio of its growth
+ * (the whole window if it never did). Residual memory is reported both before and after the
+ * purge, as bytes and as a ratio of the growth. Growth and residual are relative to the RSS
+ * before the first iteration. Iterations whose heap didn't grow RSS (it fit into memory retained
+ * earlier) are counted in ZeroGrowthIterations and left out of the averages.
+ */
+static void BM_MemoryReturn(benchmark::State& state)
+{
+    const std::size_t heapBytes = static_cast<std::size_t>(state.range(0)) << 20;
+    const auto window = GetDecayWindow();
+
+    double growthSum = 0;
+    double releaseTimeMsSum = 0;
+    double residualSum = 0;
+    double residualAfterPurgeSum = 0;
+    double purgeTimeUsSum = 0;
+    uint64_t releasedInWindow = 0;
+    uint64_t measuredIterations = 0;
+    bool purgeSupported = false;
+
+    std::vector<std::pair<void*, std::size_t>> live;
+    uint64_t rngState = g_memoryReturnXorshiftSeed;
+
+    bm::utils::MemorySampler memorySampler("BM_MemoryReturn/" + std::to_string(state.range(0)) +
+                                           "/" + std::to_string(state.range(1)));
+    // One baseline for all iterations: whatever an iteration keeps raises the residual of the next
+    const std::size_t rssBefore = bm::utils::GetProcCurrentMemoryUsage();
+    memorySampler.Start();
+    for (auto _ : state) {
+        switch (state.range(1)) {
+            case 0:
+                BuildHeap(live, g_smallSizes, heapBytes, rngState);
+                break;
+            case 1:
+                BuildHeap(live, g_mediumSizes, heapBytes, rngState);
+                break;
+            default:
+                BuildHeap(live, g_combinedSizes, heapBytes, rngState);
+                break;
+        }
+        const std::size_t rssPeak = bm::utils::GetProcCurrentMemoryUsage();
+        const std::size_t growth = rssPeak > rssBefore ? rssPeak - rssBefore : 0;
+
+        for (auto& [ptr, size] : live)
+            BenchmarkDeallocate(ptr);
+        live.clear();
+
+        // Sample until RSS is back to the released threshold or the window is over
+        auto freed = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::steady_clock::duration::zero();
+        std::size_t residual = 0;
+        bool released = false;
+        while (true) {
+            std::size_t rss = bm::utils::GetProcCurrentMemoryUsage();
+            residual = rss > rssBefore ? rss - rssBefore : 0;
+            elapsed = std::chrono::steady_clock::now() - freed;
+            if (residual <= growth * g_memoryReturnReleasedRatio) {
+                released = true;
+                break;
+            }
+            if (elapsed >= window)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(g_memoryReturnSampleIntervalMs));
+        }
+
+        auto purgeStart = std::chrono::steady_clock::now();
+        purgeSupported = BenchmarkAllocatorPurge();
+        auto purgeEnd = std::chrono::steady_clock::now();
+        std::size_t rssAfterPurge = bm::utils::GetProcCurrentMemoryUsage();
+
+        state.SetIterationTime(std::chrono::duration<double>(elapsed).count());
+
+        // The heap fit into memory retained by earlier iterations, there was nothing to return
+        if (growth == 0)
+            continue;
+
+        ++measuredIterations;
+        growthSum += growth;
+        releaseTimeMsSum += std::chrono::duration<double, std::milli>(elapsed).count();
+        residualSum += residual;
+        residualAfterPurgeSum += rssAfterPurge > rssBefore ? rssAfterPurge - rssBefore : 0;
+        purgeTimeUsSum += std::chrono::duration<double, std::micro>(purgeEnd - purgeStart).count();
+        releasedInWindow += released;
+    }
+    memorySampler.Stop();
+
+    const double iterations = measuredIterations > 0 ? measuredIterations : 1;
+    state.SetLabel(purgeSupported ? "purge" : "no-purge");
+    state.counters["ZeroGrowthIterations"] = state.iterations() - measuredIterations;
+    state.counters["RssGrowth"] = growthSum / iterations;
+    state.counters["ReleaseTimeMs"] = releaseTimeMsSum / iterations;
+    state.counters["ReleasedInWindow"] = releasedInWindow / iterations;
+    state.counters["ResidualBytes"] = residualSum / iterations;
+    state.counters["ResidualRatio"] = growthSum > 0 ? residualSum / growthSum : 0;
+    state.counters["ResidualAfterPurgeBytes"] = residualAfterPurgeSum / iterations;
+    state.counters["ResidualAfterPurgeRatio"] =
+        growthSum > 0 ? residualAfterPurgeSum / growthSum : 0;
+    state.counters["PurgeTimeUs"] = purgeTimeUsSum / iterations;
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    memorySampler.Export(state);
+}
+
+BENCHMARK(BM_MemoryReturn)
+    ->ArgNames({ "heapMiB", "sizes" })
+    ->ArgsProduct({ { 64, 512 }, { 0, 1, 2 } })
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
@@ -0,0 +1,359 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    struct NumaNode
+    {
+        int id;
+        //! @brief CPUs of the node this process may run on
+        std::vector<int> cpus;
+    };
+
+    //! @brief Parses a sysfs list such as "0-3,8,10-11"
+    std::vector<int> ParseIdList(const std::string& t_list)
+    {
+        std::vector<int> ids;
+        std::size_t pos = 0;
+        while (pos < t_list.size()) {
+            std::size_t end = t_list.find(',', pos);
+            if (end == std::string::npos)
+                end = t_list.size();
+
+            const std::string range = t_list.substr(pos, end - pos);
+            const std::size_t dash = range.find('-');
+            if (!range.empty()) {
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int id = first; id <= last; ++id)
+                    ids.push_back(id);
+            }
+            pos = end + 1;
+        }
+
+        return ids;
+    }
+
+    std::string ReadLine(const std::string& t_path)
+    {
+        std::ifstream file(t_path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    /**
+     * @brief Online NUMA nodes (from /sys/devices/system/node) that have CPUs in the affinity mask
+     * of the process. Without NUMA information all allowed CPUs form a single node 0.
+     */
+    std::vector<NumaNode> GetNumaNodes()
+    {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+
+        std::vector<NumaNode> nodes;
+        for (int id : ParseIdList(ReadLine("/sys/devices/system/node/online"))) {
+            NumaNode node{ id, {} };
+            const std::string cpuList =
+                ReadLine("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            for (int cpu : ParseIdList(cpuList)) {
+                if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                    node.cpus.push_back(cpu);
+            }
+            if (!node.cpus.empty())
+                nodes.push_back(std::move(node));
+        }
+
+        if (nodes.empty()) {
+            NumaNode node{ 0, {} };
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &allowed))
+                    node.cpus.push_back(cpu);
+            }
+            nodes.push_back(std::move(node));
+        }
+
+        return nodes;
+    }
+
+    bool PinCurrentThread(int t_cpu)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(t_cpu, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+
+    /**
+     * @brief Counts how many of t_pages are resident on t_node. move_pages() without target
+     * nodes only queries where the pages are (it's called directly, so libnuma isn't needed).
+     * @return false if the kernel doesn't allow the query
+     */
+    bool CountLocalPages(const std::vector<void*>& t_pages,
+                         int t_node,
+                         uint64_t& t_local,
+                         uint64_t& t_resident)
+    {
+        std::vector<int> status(g_numaPagesPerQuery);
+        for (std::size_t first = 0; first < t_pages.size(); first += g_numaPagesPerQuery) {
+            const std::size_t count =
+                std::min<std::size_t>(g_numaPagesPerQuery, t_pages.size() - first);
+            if (syscall(SYS_move_pages, 0, count, &t_pages[first], nullptr, status.data(), 0) != 0)
+                return false;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                // Negative values are errors, e.g. -ENOENT for pages that aren't resident
+                if (status[i] >= 0) {
+                    ++t_resident;
+                    t_local += status[i] == t_node;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    struct alignas(64) ListNode
+    {
+        ListNode* next;
+        uint32_t data;
+    };
+
+    //! @brief Threads wait until all t_parties arrived, can be reused for the next phase.
+    class SpinBarrier
+    {
+    public:
+        explicit SpinBarrier(uint32_t t_parties)
+            : m_parties(t_parties)
+        {}
+
+        void Wait()
+        {
+            const uint32_t phase = m_phase.load(std::memory_order_acquire);
+            if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_parties) {
+                m_arrived.store(0, std::memory_order_relaxed);
+                m_phase.fetch_add(1, std::memory_order_acq_rel);
+                return;
+            }
+
+            while (m_phase.load(std::memory_order_acquire) == phase)
+                std::this_thread::yield();
+        }
+
+    private:
+        const uint32_t m_parties;
+        std::atomic<uint32_t> m_arrived{ 0 };
+        std::atomic<uint32_t> m_phase{ 0 };
+    };
+
+    //! @brief State of a worker, written by the worker, read by the others after a barrier
+    struct NumaWorker
+    {
+        int cpu = -1;
+        int node = 0;
+        bool pinned = false;
+        ListNode* head = nullptr;
+        double allocNs = 0;
+        double localNs = 0;
+        double remoteNs = 0;
+        uint64_t localPages = 0;
+        uint64_t residentPages = 0;
+        bool pagesKnown = false;
+        //! @brief g_numaCacheEvictBytes, first touched by the worker, so it's on its node
+        std::vector<uint8_t> evictBuffer;
+    };
+
+    /**
+     * @brief Allocates t_totalNodes list nodes and links them in allocation order or, if
+     * t_randomized, in a shuffled order.
+     */
+    ListNode* CreateList(uint32_t t_totalNodes, bool t_randomized, uint64_t t_seed)
+    {
+        std::vector<ListNode*> nodes(t_totalNodes);
+        for (uint32_t i = 0; i < t_totalNodes; ++i)
+            nodes[i] = new (BenchmarkAllocate(sizeof(ListNode))) ListNode{ nullptr, i };
+
+        if (t_randomized) {
+            for (uint32_t i = t_totalNodes - 1; i > 0; --i)
+                std::swap(nodes[i], nodes[bm::utils::XorshiftNext(t_seed) % (i + 1)]);
+        }
+
+        for (uint32_t i = 0; i + 1 < t_totalNodes; ++i)
+            nodes[i]->next = nodes[i + 1];
+        return nodes[0];
+    }
+
+    //! @brief Writes every cache line of t_buffer, so that no list node is cached any more
+    void EvictCaches(std::vector<uint8_t>& t_buffer)
+    {
+        for (std::size_t i = 0; i < t_buffer.size(); i += 64)
+            ++t_buffer[i];
+        benchmark::ClobberMemory();
+    }
+
+    uint32_t TraverseList(ListNode* t_head)
+    {
+        uint32_t data = 0;
+        for (ListNode* node = t_head; node != nullptr; node = node->next)
+            data = data ^ 0x1337AF12 ^ node->data;
+        return data;
+    }
+
+    std::vector<void*> GetListPages(ListNode* t_head)
+    {
+        const uintptr_t pageMask = ~static_cast<uintptr_t>(sysconf(_SC_PAGESIZE) - 1);
+        std::vector<void*> pages;
+        for (ListNode* node = t_head; node != nullptr; node = node->next)
+            pages.push_back(reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(node) & pageMask));
+
+        std::sort(pages.begin(), pages.end());
+        pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+        return pages;
+    }
+
+    double ElapsedNs(std::chrono::steady_clock::time_point t_start)
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t_start)
+            .count();
+    }
+}
+
+/**
+ * @brief Allocator locality on NUMA machines. One worker per NUMA node (at least two), each pinned
+ * to a CPU of its node, allocates a linked list of range(0) 64 byte nodes (linked in allocation
+ * order, or shuffled if range(1) is set) and traverses it BENCHMARK_MEM_ACCESS-style. Then every
+ * worker traverses the list of the next worker, which lives on another node. Every worker evicts
+ * the caches (walks a buffer bigger than the LLC) before both traversals, so that neither of them
+ * starts from a list that is still cached.
+ *
+ * Reports LocalPageRatio (pages of a worker's list that are on its own node, via move_pages()),
+ * AllocNsPerNode, LocalNsPerNode/RemoteNsPerNode and RemotePenalty (remote / local traversal
+ * time). On single-node machines workers are only pinned to different CPUs, so RemotePenalty
+ * shows cache effects only. Time is the local traversal.
+ */
+static void BM_NumaLocality(benchmark::State& state)
+{
+    const uint32_t listNodes = state.range(0);
+    const bool randomized = state.range(1) != 0;
+
+    if (!BenchmarkAllocatorHas(kBenchmarkCapThreadSafe)) {
+        state.SkipWithError("Allocator is not thread-safe");
+        return;
+    }
+
+    const std::vector<NumaNode> numaNodes = GetNumaNodes();
+    const uint32_t totalWorkers = std::max<uint32_t>(2, numaNodes.size());
+    std::vector<NumaWorker> workers(totalWorkers);
+    for (uint32_t i = 0; i < totalWorkers; ++i) {
+        const NumaNode& node = numaNodes[i % numaNodes.size()];
+        workers[i].node = node.id;
+        workers[i].cpu = node.cpus[(i / numaNodes.size()) % node.cpus.size()];
+    }
+
+    double allocNs = 0;
+    double localNs = 0;
+    double remoteNs = 0;
+    uint64_t localPages = 0;
+    uint64_t residentPages = 0;
+    bool pagesKnown = true;
+    bool pinned = true;
+
+    for (auto _ : state) {
+        SpinBarrier barrier(totalWorkers);
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < totalWorkers; ++i) {
+            threads.emplace_back([&, i]() {
+                NumaWorker& worker = workers[i];
+                worker.pinned = PinCurrentThread(worker.cpu);
+                BenchmarkThreadInitialize();
+                if (worker.evictBuffer.empty())
+                    worker.evictBuffer.resize(g_numaCacheEvictBytes);
+
+                auto start = std::chrono::steady_clock::now();
+                worker.head = CreateList(listNodes, randomized, g_numaXorshiftSeed + i);
+                worker.allocNs = ElapsedNs(start);
+
+                worker.localPages = 0;
+                worker.residentPages = 0;
+                worker.pagesKnown = CountLocalPages(GetListPages(worker.head),
+                                                    worker.node,
+                                                    worker.localPages,
+                                                    worker.residentPages);
+                EvictCaches(worker.evictBuffer);
+                barrier.Wait();
+
+                start = std::chrono::steady_clock::now();
+                benchmark::DoNotOptimize(TraverseList(worker.head));
+                worker.localNs = ElapsedNs(start);
+                barrier.Wait();
+
+                EvictCaches(worker.evictBuffer);
+                barrier.Wait();
+
+                start = std::chrono::steady_clock::now();
+                benchmark::DoNotOptimize(TraverseList(workers[(i + 1) % totalWorkers].head));
+                worker.remoteNs = ElapsedNs(start);
+                barrier.Wait();
+
+                for (ListNode* node = worker.head; node != nullptr;) {
+                    ListNode* next = node->next;
+                    BenchmarkDeallocate(node);
+                    node = next;
+                }
+                worker.head = nullptr;
+                BenchmarkThreadFinalize();
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        double iterationNs = 0;
+        for (auto& worker : workers) {
+            allocNs += worker.allocNs;
+            localNs += worker.localNs;
+            remoteNs += worker.remoteNs;
+            localPages += worker.localPages;
+            residentPages += worker.residentPages;
+            pagesKnown = pagesKnown && worker.pagesKnown;
+            pinned = pinned && worker.pinned;
+            iterationNs = std::max(iterationNs, worker.localNs);
+        }
+        state.SetIterationTime(iterationNs / 1e9);
+    }
+
+    const double traversedNodes =
+        static_cast<double>(listNodes) * totalWorkers * state.iterations();
+    state.SetLabel(std::to_string(numaNodes.size()) + (numaNodes.size() > 1 ? " nodes" : " node") +
+                   (pinned ? "" : ", unpinned") + (pagesKnown ? "" : ", no page info"));
+    state.counters["NumaNodes"] = numaNodes.size();
+    state.counters["Workers"] = totalWorkers;
+    if (pagesKnown && residentPages > 0)
+        state.counters["LocalPageRatio"] = static_cast<double>(localPages) / residentPages;
+    state.counters["AllocNsPerNode"] = allocNs / traversedNodes;
+    state.counters["LocalNsPerNode"] = localNs / traversedNodes;
+    state.counters["RemoteNsPerNode"] = remoteNs / traversedNodes;
+    state.counters["RemotePenalty"] = localNs > 0 ? remoteNs / localNs : 0;
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+}
+
+BENCHMARK(BM_NumaLocality)
+    ->ArgNames({ "listNodes", "randomized" })
+    ->ArgsProduct({ { g_numaListNodesRangeStart, g_numaListNodesRangeEnd }, { 0, 1 } })
+    ->Iterations(5)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
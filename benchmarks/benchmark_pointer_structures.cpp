@@ -0,0 +1,10 @@
+#include "pointer_structures.h"
+
+/**
+ * @brief Traversals of pointer-based structures built from BenchmarkAllocate() nodes. Nodes are
+ * allocated in random key order, so the results show how well the allocator keeps logically
+ * unrelated but temporally close allocations together. memplusplus additionally runs the same
+ * structures on SharedGcPtr, before and after relayout (mempp/benchmark_memory_access.cpp).
+ */
+static const int s_totalTraversalBenchmarks =
+    bm::ds::RegisterTraversalBenchmarks<bm::ds::RawPointers>("", false);
@@ -0,0 +1,202 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    struct SizeProbe
+    {
+        std::size_t size;
+        //! @brief Size is a class edge or next to one
+        bool edge;
+        std::size_t usableSize;
+        double allocNsSum;
+        double freeNsSum;
+    };
+
+    /**
+     * @brief Finds the size classes of the allocator in [t_min, t_max]. The usable size of a chunk
+     * is the biggest size of its class, so the next class starts right after it.
+     * @return Largest size of every class, empty if the allocator doesn't report usable sizes.
+     */
+    std::vector<std::size_t> FindClassEdges(std::size_t t_min, std::size_t t_max)
+    {
+        std::vector<std::size_t> edges;
+        std::size_t size = t_min;
+        while (size <= t_max) {
+            void* ptr = BenchmarkAllocate(size);
+            std::size_t usableSize = BenchmarkUsableSize(ptr);
+            BenchmarkDeallocate(ptr);
+            if (usableSize < size)
+                return {};
+
+            edges.push_back(usableSize);
+            size = usableSize + 1;
+        }
+
+        return edges;
+    }
+
+    //! @brief Step of the fixed size grid at t_size: finer for small sizes
+    std::size_t GetGridStep(std::size_t t_size)
+    {
+        if (t_size < 1024)
+            return g_sizeClassGridStepSmall;
+        if (t_size < 8192)
+            return g_sizeClassGridStepMedium;
+        return g_sizeClassGridStepBig;
+    }
+
+    //! @brief Fixed grid over [t_min, t_max] plus every class edge +-1
+    std::vector<SizeProbe> BuildProbes(std::size_t t_min, std::size_t t_max)
+    {
+        std::vector<SizeProbe> probes;
+        for (std::size_t size = t_min; size <= t_max; size += GetGridStep(size))
+            probes.push_back({ size, false, 0, 0, 0 });
+
+        for (std::size_t edge : FindClassEdges(t_min, t_max)) {
+            for (std::size_t size : { edge - 1, edge, edge + 1 }) {
+                if (size >= t_min && size <= t_max)
+                    probes.push_back({ size, true, 0, 0, 0 });
+            }
+        }
+
+        // Grid sizes that happen to be edges are kept once, as edges
+        std::sort(probes.begin(), probes.end(), [](const SizeProbe& t_lhs, const SizeProbe& t_rhs) {
+            return t_lhs.size < t_rhs.size || (t_lhs.size == t_rhs.size && t_lhs.edge > t_rhs.edge);
+        });
+        probes.erase(std::unique(probes.begin(),
+                                 probes.end(),
+                                 [](const SizeProbe& t_lhs, const SizeProbe& t_rhs) {
+                                     return t_lhs.size == t_rhs.size;
+                                 }),
+                     probes.end());
+        return probes;
+    }
+
+    /**
+     * @brief Appends the per-size results to the MPP_BENCH_SIZE_CLASS_LOG CSV file (if configured)
+     * as "benchmark,size,edge,usable_size,alloc_ns,free_ns".
+     */
+    void AppendSizeClassLog(const std::string& t_name,
+                            const std::vector<SizeProbe>& t_probes,
+                            uint64_t t_iterations)
+    {
+        const char* path = std::getenv("MPP_BENCH_SIZE_CLASS_LOG");
+        if (path == nullptr)
+            return;
+
+        std::ofstream log(path, std::ios::app);
+        if (log.tellp() == 0)
+            log << "benchmark,size,edge,usable_size,alloc_ns,free_ns\n";
+
+        for (auto& probe : t_probes) {
+            log << t_name << ',' << probe.size << ',' << probe.edge << ',' << probe.usableSize
+                << ',' << probe.allocNsSum / t_iterations << ',' << probe.freeNsSum / t_iterations
+                << '\n';
+        }
+    }
+}
+
+/**
+ * @brief Sweeps every size in [range(0), range(1)] on a fixed grid, plus the sizes around each
+ * class edge of the allocator (found through BenchmarkUsableSize()). For every size a batch of
+ * g_sizeClassBatch chunks is allocated and then freed, which keeps the allocator on its fast path
+ * for that size. Reports mean/max per-operation latency (with the size of the slowest one) and the
+ * internal fragmentation (usable - requested bytes). Per-size numbers go to
+ * MPP_BENCH_SIZE_CLASS_LOG.
+ */
+static void BM_SizeClassSweep(benchmark::State& state)
+{
+    const std::size_t minSize = state.range(0);
+    const std::size_t maxSize = state.range(1);
+
+    std::vector<SizeProbe> probes = BuildProbes(minSize, maxSize);
+    std::vector<void*> chunks(g_sizeClassBatch);
+
+    for (auto _ : state) {
+        double iterationNs = 0;
+        for (auto& probe : probes) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (auto& chunk : chunks)
+                chunk = BenchmarkAllocate(probe.size);
+            auto allocated = std::chrono::high_resolution_clock::now();
+            for (auto& chunk : chunks)
+                BenchmarkDeallocate(chunk);
+            auto freed = std::chrono::high_resolution_clock::now();
+
+            double allocNs = std::chrono::duration<double, std::nano>(allocated - start).count();
+            double freeNs = std::chrono::duration<double, std::nano>(freed - allocated).count();
+            probe.allocNsSum += allocNs / g_sizeClassBatch;
+            probe.freeNsSum += freeNs / g_sizeClassBatch;
+            iterationNs += allocNs + freeNs;
+        }
+
+        state.SetIterationTime(iterationNs / 1e9);
+    }
+
+    // Usable sizes are taken outside of the timed batches
+    for (auto& probe : probes) {
+        void* ptr = BenchmarkAllocate(probe.size);
+        probe.usableSize = BenchmarkUsableSize(ptr);
+        BenchmarkDeallocate(ptr);
+    }
+
+    const double iterations = static_cast<double>(state.iterations());
+    double allocNsSum = 0;
+    double freeNsSum = 0;
+    const SizeProbe* slowestAlloc = &probes.front();
+    const SizeProbe* slowestFree = &probes.front();
+    double requestedBytes = 0;
+    double wastedBytes = 0;
+    std::size_t wastedBytesMax = 0;
+    uint64_t edges = 0;
+    for (auto& probe : probes) {
+        allocNsSum += probe.allocNsSum;
+        freeNsSum += probe.freeNsSum;
+        if (probe.allocNsSum > slowestAlloc->allocNsSum)
+            slowestAlloc = &probe;
+        if (probe.freeNsSum > slowestFree->freeNsSum)
+            slowestFree = &probe;
+
+        if (probe.usableSize >= probe.size) {
+            requestedBytes += probe.size;
+            wastedBytes += probe.usableSize - probe.size;
+            wastedBytesMax = std::max(wastedBytesMax, probe.usableSize - probe.size);
+        }
+        edges += probe.edge;
+    }
+
+    state.counters["Sizes"] = probes.size();
+    state.counters["EdgeSizes"] = edges;
+    state.counters["AllocNsMean"] = allocNsSum / probes.size() / iterations;
+    state.counters["AllocNsMax"] = slowestAlloc->allocNsSum / iterations;
+    state.counters["AllocNsMaxSize"] = slowestAlloc->size;
+    state.counters["FreeNsMean"] = freeNsSum / probes.size() / iterations;
+    state.counters["FreeNsMax"] = slowestFree->freeNsSum / iterations;
+    state.counters["FreeNsMaxSize"] = slowestFree->size;
+    // Only sizes with a known usable size, see BenchmarkUsableSize()
+    state.counters["WastedRatio"] = requestedBytes > 0 ? wastedBytes / requestedBytes : 0;
+    state.counters["WastedBytesMax"] = wastedBytesMax;
+
+    AppendSizeClassLog("BM_SizeClassSweep/" + std::to_string(minSize) + "/" +
+                           std::to_string(maxSize),
+                       probes,
+                       state.iterations());
+}
+
+BENCHMARK(BM_SizeClassSweep)
+    ->ArgNames({ "min", "max" })
+    ->Args({ 8, 1024 })
+    ->Args({ 1024, 8192 })
+    ->Args({ 8192, 64 << 10 })
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
@@ -0,0 +1,191 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "latency_histogram.h"
+#include "memory_sampler.h"
+#include "workload_generator.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    //! @brief Written by a churn thread, read by the parent after join()
+    struct ChurnThreadResult
+    {
+        //! @brief BenchmarkThreadInitialize() and the first allocation, in ReadTimestamp() ticks
+        uint64_t setupTicks = 0;
+        //! @brief Every other allocation and free of the slice
+        uint64_t workTicks = 0;
+        uint64_t workOps = 0;
+        //! @brief Chunks left to the parent, freed after the thread exited
+        std::vector<void*> handoff;
+    };
+
+    /**
+     * @brief Body of a churn thread: runs its slice of t_sizes through a ring of
+     * g_threadChurnLiveChunks live chunks, frees what is left except for g_threadChurnHandoffChunks
+     * chunks, which outlive the thread.
+     */
+    void RunChurnThread(const std::vector<std::size_t>& t_sizes, ChurnThreadResult& t_result)
+    {
+        std::vector<void*> ring(g_threadChurnLiveChunks, nullptr);
+
+        uint64_t start = bm::utils::ReadTimestamp();
+        BenchmarkThreadInitialize();
+        ring[0] = BenchmarkAllocate(t_sizes[0]);
+        uint64_t setupEnd = bm::utils::ReadTimestamp();
+        *static_cast<char*>(ring[0]) = 1;
+
+        uint64_t ops = 0;
+        for (std::size_t i = 1; i < t_sizes.size(); ++i) {
+            void*& slot = ring[i % ring.size()];
+            if (slot) {
+                BenchmarkDeallocate(slot);
+                ++ops;
+            }
+            slot = BenchmarkAllocate(t_sizes[i]);
+            *static_cast<char*>(slot) = 1;
+            ++ops;
+        }
+
+        for (std::size_t i = 0; i < ring.size(); ++i) {
+            if (ring[i] == nullptr)
+                continue;
+
+            if (i < g_threadChurnHandoffChunks) {
+                t_result.handoff.push_back(ring[i]);
+            } else {
+                BenchmarkDeallocate(ring[i]);
+                ++ops;
+            }
+        }
+        uint64_t end = bm::utils::ReadTimestamp();
+
+        BenchmarkThreadFinalize();
+        t_result.setupTicks += setupEnd - start;
+        t_result.workTicks += end - setupEnd;
+        t_result.workOps += ops;
+    }
+
+    std::size_t GetMappedBytes()
+    {
+        BenchmarkAllocatorStats stats;
+        return BenchmarkAllocatorGetStats(stats) ? stats.mappedBytes : 0;
+    }
+}
+
+/**
+ * @brief Thread pools that resize: every iteration runs g_threadChurnWaves waves of range(0)
+ * threads, each of which allocates and frees a slice of range(1) requests (sizes from the
+ * workload, small by default) and exits. Chunks handed off by a thread are freed by the parent
+ * after join(), i.e. into the heap of a thread that no longer exists. Time covers thread creation,
+ * the slices, thread exit and the handoff frees.
+ *
+ * Reports thread and operation throughput, ThreadSetupNs (BenchmarkThreadInitialize() and the
+ * first allocation of a fresh thread), OpNs (the rest of the slice), OrphanFreeNs, and the memory
+ * left behind by abandoned thread caches once everything was freed: RSS (and allocator mapped
+ * bytes) growth over the run, before and after BenchmarkAllocatorPurge().
+ */
+static void BM_ThreadChurn(benchmark::State& state)
+{
+    const uint32_t totalThreads = state.range(0);
+    const uint32_t sliceOps = state.range(1);
+
+    if (!BenchmarkAllocatorHas(kBenchmarkCapThreadSafe)) {
+        state.SkipWithError("Allocator is not thread-safe");
+        return;
+    }
+
+    // Precompute the slices, so that RNG doesn't end up in the timed region
+    std::vector<std::vector<std::size_t>> sizes;
+    for (uint32_t thread = 0; thread < totalThreads; ++thread) {
+        sizes.push_back(bm::utils::PrecomputeSizes(
+            bm::workload::GetSizes("small"), sliceOps, g_threadChurnXorshiftSeed + thread));
+    }
+
+    std::vector<ChurnThreadResult> results(totalThreads);
+    std::vector<std::thread> threads;
+    threads.reserve(totalThreads);
+    uint64_t orphanFreeTicks = 0;
+    uint64_t orphanFrees = 0;
+
+    bm::utils::MemorySampler memorySampler("BM_ThreadChurn/" + std::to_string(totalThreads) + "/" +
+                                           std::to_string(sliceOps));
+    const std::size_t rssBefore = bm::utils::GetProcCurrentMemoryUsage();
+    const std::size_t mappedBefore = GetMappedBytes();
+    memorySampler.Start();
+    for (auto _ : state) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t wave = 0; wave < g_threadChurnWaves; ++wave) {
+            for (uint32_t thread = 0; thread < totalThreads; ++thread) {
+                threads.emplace_back(
+                    RunChurnThread, std::cref(sizes[thread]), std::ref(results[thread]));
+            }
+            for (auto& thread : threads)
+                thread.join();
+            threads.clear();
+
+            uint64_t freeStart = bm::utils::ReadTimestamp();
+            for (auto& result : results) {
+                for (void* ptr : result.handoff)
+                    BenchmarkDeallocate(ptr);
+                orphanFrees += result.handoff.size();
+                result.handoff.clear();
+            }
+            orphanFreeTicks += bm::utils::ReadTimestamp() - freeStart;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        state.SetIterationTime(
+            std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());
+    }
+    memorySampler.Stop();
+
+    // Everything is freed, whatever is still held belongs to caches of exited threads
+    const std::size_t rssAfter = bm::utils::GetProcCurrentMemoryUsage();
+    const std::size_t mappedAfter = GetMappedBytes();
+    const bool purgeSupported = BenchmarkAllocatorPurge();
+    const std::size_t rssAfterPurge = bm::utils::GetProcCurrentMemoryUsage();
+
+    const double ticksPerNs = bm::utils::GetTimestampTicksPerNs();
+    const double threadsRun =
+        static_cast<double>(totalThreads) * g_threadChurnWaves * state.iterations();
+    uint64_t setupTicks = 0;
+    uint64_t workTicks = 0;
+    uint64_t workOps = 0;
+    for (auto& result : results) {
+        setupTicks += result.setupTicks;
+        workTicks += result.workTicks;
+        workOps += result.workOps;
+    }
+
+    state.SetLabel(purgeSupported ? "purge" : "no-purge");
+    state.counters["ThreadsPerSecond"] =
+        benchmark::Counter(threadsRun, benchmark::Counter::kIsRate);
+    state.counters["OpsPerSecond"] =
+        benchmark::Counter(workOps + threadsRun + orphanFrees, benchmark::Counter::kIsRate);
+    state.counters["ThreadSetupNs"] = setupTicks / ticksPerNs / threadsRun;
+    state.counters["OpNs"] = workOps ? workTicks / ticksPerNs / workOps : 0;
+    state.counters["OrphanFreeNs"] = orphanFrees ? orphanFreeTicks / ticksPerNs / orphanFrees : 0;
+    state.counters["RssLeftBehind"] = rssAfter > rssBefore ? rssAfter - rssBefore : 0;
+    state.counters["RssLeftBehindAfterPurge"] =
+        rssAfterPurge > rssBefore ? rssAfterPurge - rssBefore : 0;
+    if (mappedBefore || mappedAfter) {
+        state.counters["MappedLeftBehind"] =
+            mappedAfter > mappedBefore ? mappedAfter - mappedBefore : 0;
+    }
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    memorySampler.Export(state);
+}
+
+BENCHMARK(BM_ThreadChurn)
+    ->ArgNames({ "threads", "ops" })
+    ->ArgsProduct({ { 1, 4, 16 }, { 256, 4096 } })
+    ->Iterations(10)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
@@ -0,0 +1,230 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "memory_sampler.h"
+#include "trace_format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace bm::trace;
+
+/**
+ * @brief Read-only mapping of a trace file recorded by trace_recorder.
+ */
+class MappedTrace
+{
+public:
+    explicit MappedTrace(const std::string& t_path)
+        : m_path(t_path)
+    {
+        int fd = open(t_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("Failed to open trace: " + t_path);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(TraceHeader)) {
+            close(fd);
+            throw std::runtime_error("Trace is too small: " + t_path);
+        }
+
+        m_size = st.st_size;
+        // Populate upfront, so that replay doesn't take page faults on the trace itself
+        m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        close(fd);
+        if (m_data == MAP_FAILED)
+            throw std::runtime_error("Failed to mmap trace: " + t_path);
+
+        Validate(t_path);
+    }
+
+    MappedTrace(const MappedTrace&) = delete;
+    MappedTrace& operator=(const MappedTrace&) = delete;
+
+    ~MappedTrace()
+    {
+        munmap(m_data, m_size);
+    }
+
+    const TraceHeader& GetHeader() const
+    {
+        return *static_cast<const TraceHeader*>(m_data);
+    }
+
+    const std::string& GetPath() const
+    {
+        return m_path;
+    }
+
+    const TraceEvent* GetEvents() const
+    {
+        return reinterpret_cast<const TraceEvent*>(static_cast<const char*>(m_data) +
+                                                   sizeof(TraceHeader));
+    }
+
+private:
+    std::string m_path;
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+
+    /**
+     * @brief Checks the header and every event: known op, object id below totalObjects and, for
+     * ALLOC_ALIGNED, an alignment of at most 1 << c_traceMaxAlignmentLog2.
+     */
+    void Validate(const std::string& t_path) const
+    {
+        const TraceHeader& header = GetHeader();
+        if (std::memcmp(header.magic, c_traceMagic, sizeof(c_traceMagic)) != 0 ||
+            header.version != c_traceVersion)
+            throw std::runtime_error("Not a trace (or unsupported version): " + t_path);
+
+        if (sizeof(TraceHeader) + header.totalEvents * sizeof(TraceEvent) > m_size)
+            throw std::runtime_error("Trace is truncated: " + t_path);
+
+        const TraceEvent* events = GetEvents();
+        for (uint64_t i = 0; i < header.totalEvents; ++i) {
+            const std::string event = "Trace event " + std::to_string(i);
+            if (events[i].op >= TraceOp::COUNT)
+                throw std::runtime_error(event + " has an unknown op: " + t_path);
+            if (events[i].objectId >= header.totalObjects) {
+                throw std::runtime_error(event + " references object " +
+                                         std::to_string(events[i].objectId) + " of " +
+                                         std::to_string(header.totalObjects) + ": " + t_path);
+            }
+            if (events[i].op == TraceOp::ALLOC_ALIGNED &&
+                events[i].arg > c_traceMaxAlignmentLog2) {
+                throw std::runtime_error(event + " has an alignment of 2^" +
+                                         std::to_string(events[i].arg) + ", more than 2^" +
+                                         std::to_string(c_traceMaxAlignmentLog2) + ": " + t_path);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Replays a recorded allocation trace in recorded order (on a single thread). Object ids
+ * from the trace are indices into a flat slot table, so replay doesn't pay for any lookups.
+ */
+static void BM_TraceReplay(benchmark::State& state, std::shared_ptr<const MappedTrace> trace)
+{
+    const TraceHeader& header = trace->GetHeader();
+    const TraceEvent* events = trace->GetEvents();
+    const bool useAligned = BenchmarkAllocatorHas(kBenchmarkCapAllocateAligned);
+
+    struct Slot
+    {
+        void* ptr;
+        std::size_t size;
+    };
+    std::vector<Slot> slots(header.totalObjects);
+
+    bm::utils::MemorySampler memorySampler("BM_TraceReplay/" + trace->GetPath());
+    memorySampler.Start();
+    for (auto _ : state) {
+        std::fill(slots.begin(), slots.end(), Slot{ nullptr, 0 });
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint64_t i = 0; i < header.totalEvents; ++i) {
+            const TraceEvent& event = events[i];
+            Slot& slot = slots[event.objectId];
+            switch (event.op) {
+                case TraceOp::ALLOC:
+                    slot.ptr = BenchmarkAllocate(event.size);
+                    slot.size = event.size;
+                    break;
+                case TraceOp::ALLOC_ALIGNED: {
+                    const std::size_t alignment =
+                        std::max(std::size_t(1) << event.arg, sizeof(void*));
+                    slot.ptr = useAligned ? BenchmarkAllocateAligned(alignment, event.size)
+                                          : BenchmarkAllocate(event.size);
+                    slot.size = event.size;
+                    break;
+                }
+                case TraceOp::ALLOC_ZEROED:
+                    slot.ptr = BenchmarkAllocateZeroed(1, event.size);
+                    slot.size = event.size;
+                    break;
+                case TraceOp::REALLOC:
+                    slot.ptr = BenchmarkReallocate(slot.ptr, slot.size, event.size);
+                    slot.size = event.size;
+                    break;
+                case TraceOp::FREE:
+                    BenchmarkDeallocate(slot.ptr);
+                    slot.ptr = nullptr;
+                    break;
+                default:
+                    break;
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        state.SetIterationTime(
+            std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());
+
+        // Objects that were still alive when the trace ended
+        for (auto& slot : slots) {
+            if (slot.ptr != nullptr)
+                BenchmarkDeallocate(slot.ptr);
+        }
+    }
+    memorySampler.Stop();
+
+    state.counters["TotalEvents"] = header.totalEvents;
+    state.counters["TotalThreads"] = header.totalThreads;
+    state.counters["EventsPerSecond"] = benchmark::Counter(
+        static_cast<double>(header.totalEvents) * state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    memorySampler.Export(state);
+}
+
+/**
+ * @brief Registers BM_TraceReplay for every trace in the MPP_BENCH_TRACES environment variable
+ * (colon-separated list of trace files). Traces are mapped and validated once, here.
+ */
+static int RegisterTraceReplayBenchmarks()
+{
+    const char* traces = std::getenv("MPP_BENCH_TRACES");
+    if (traces == nullptr)
+        return 0;
+
+    int registered = 0;
+    std::string list(traces);
+    std::size_t begin = 0;
+    while (begin <= list.size()) {
+        std::size_t end = list.find(':', begin);
+        if (end == std::string::npos)
+            end = list.size();
+
+        std::string path = list.substr(begin, end - begin);
+        if (!path.empty()) {
+            try {
+                auto trace = std::make_shared<const MappedTrace>(path);
+                benchmark::RegisterBenchmark(
+                    ("BM_TraceReplay/" + path).c_str(), BM_TraceReplay, std::move(trace))
+                    ->Unit(benchmark::kMillisecond)
+                    ->UseManualTime();
+                ++registered;
+            } catch (const std::exception& e) {
+                std::cerr << "Skipping trace replay: " << e.what() << std::endl;
+            }
+        }
+
+        begin = end + 1;
+    }
+
+    return registered;
+}
+
+static const int s_totalTraceReplayBenchmarks = RegisterTraceReplayBenchmarks();
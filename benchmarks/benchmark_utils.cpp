@@ -1,5 +1,8 @@
 #include "benchmark_utils.h"
+#include <cstdlib>
+#include <fcntl.h>
 #include <limits>
+#include <unistd.h>
 
 namespace bm::utils {
     uint64_t g_xorshiftState{ 0x0 };
@@ -45,4 +48,25 @@ namespace bm::utils {
         getrusage(RUSAGE_SELF, &rusage);
         return (std::size_t)rusage.ru_maxrss * 1024;
     }
+
+    std::size_t GetProcCurrentMemoryUsage()
+    {
+        // Plain syscalls instead of stdio, so that sampling doesn't go through the allocator
+        int fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return 0;
+
+        char buffer[128];
+        ssize_t bytesRead = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (bytesRead <= 0)
+            return 0;
+        buffer[bytesRead] = '\0';
+
+        // statm: size resident shared text lib data dt (in pages)
+        char* residentStart = nullptr;
+        std::strtoull(buffer, &residentStart, 10);
+        std::size_t residentPages = std::strtoull(residentStart, nullptr, 10);
+        return residentPages * sysconf(_SC_PAGESIZE);
+    }
 }
@@ -1,5 +1,9 @@
+#pragma once
+
+#include <cstddef>
 #include <cstdint>
 #include <sys/resource.h>
+#include <vector>
 
 namespace bm::utils {
     void XorshiftInit(uint64_t t_seed);
@@ -9,5 +13,39 @@ namespace bm::utils {
     uint64_t XorshiftNext(uint64_t t_min, uint64_t t_max);
     float XorshiftNext(uint64_t& t_state, float t_min, float t_max);
 
+    /**
+     * @brief Picks t_count sizes from t_sizes with a xorshift sequence seeded with t_seed, so
+     * that timed loops don't pay for the random number generation.
+     */
+    template<class Sizes>
+    std::vector<std::size_t> PrecomputeSizes(const Sizes& t_sizes,
+                                             std::size_t t_count,
+                                             uint64_t t_seed)
+    {
+        std::vector<std::size_t> sizes;
+        sizes.reserve(t_count);
+        for (std::size_t i = 0; i < t_count; ++i)
+            sizes.push_back(t_sizes[XorshiftNext(t_seed) % t_sizes.size()]);
+        return sizes;
+    }
+
+    /**
+     * @brief Stores the chunk size in its first bytes and writes to each of its pages, to commit
+     * them for measuring memory usage. t_size has to be 0 or at least sizeof(int64_t).
+     */
+    inline void TouchChunk(void* t_ptr, int64_t t_size)
+    {
+        *static_cast<int64_t*>(t_ptr) = t_size;
+
+        if (t_size) {
+            constexpr std::size_t c_pageSize = 4096;
+            std::size_t num_pages = (t_size - 1) / c_pageSize;
+            for (std::size_t page = 1; page < num_pages; ++page)
+                *((char*)(t_ptr) + (page * c_pageSize)) = 1;
+            *((char*)(t_ptr) + (t_size - 1)) = 1;
+        }
+    }
+
     std::size_t GetProcPeakMemoryUsage();
+    std::size_t GetProcCurrentMemoryUsage();
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "memory_sampler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Benchmarks geometric buffer growth (std::vector / string builders). Many buffers are
+ * grown round-robin with BenchmarkReallocate() from g_vectorGrowthInitialSize up to a size from
+ * g_bigSizes, every step multiplies the capacity by range(1) / 100. With probability
+ * g_vectorGrowthShrinkProbability a buffer is shrunk by g_vectorGrowthShrinkFactor once it reaches
+ * its final size (shrink_to_fit). Reallocations that return the same pointer are counted as
+ * in-place, all others as copies of the old contents.
+ */
+static void BM_VectorGrowth(benchmark::State& state)
+{
+    const uint32_t totalBuffers = state.range(0);
+    const uint32_t growthFactorPercent = state.range(1);
+
+    struct Buffer
+    {
+        void* ptr;
+        std::size_t size;
+        //! @brief Size the buffer is grown to, from finalSize and lowered once it was shrunk
+        std::size_t targetSize;
+        std::size_t finalSize;
+        bool shrink;
+    };
+
+    // Precompute the final sizes, so that RNG doesn't end up in the timed region
+    std::vector<Buffer> buffers(totalBuffers);
+    uint64_t rngState = g_vectorGrowthXorshiftSeed;
+    for (auto& buffer : buffers) {
+        buffer.finalSize = g_bigSizes[bm::utils::XorshiftNext(rngState, 0, g_bigSizes.size() - 1)];
+        buffer.shrink =
+            bm::utils::XorshiftNext(rngState, 0.0f, 1.0f) < g_vectorGrowthShrinkProbability;
+    }
+
+    uint64_t inPlaceReallocs = 0;
+    uint64_t movedReallocs = 0;
+    uint64_t bytesCopied = 0;
+
+    bm::utils::MemorySampler memorySampler("BM_VectorGrowth/" + std::to_string(totalBuffers) +
+                                           "/" + std::to_string(growthFactorPercent));
+    memorySampler.Start();
+    for (auto _ : state) {
+        for (auto& buffer : buffers) {
+            buffer.size = g_vectorGrowthInitialSize;
+            buffer.targetSize = buffer.finalSize;
+            buffer.ptr = BenchmarkAllocate(buffer.size);
+            *static_cast<char*>(buffer.ptr) = 1;
+        }
+
+        uint32_t buffersLeft = totalBuffers;
+        while (buffersLeft != 0) {
+            for (auto& buffer : buffers) {
+                if (buffer.size == buffer.targetSize)
+                    continue;
+
+                std::size_t newSize = std::min<std::size_t>(
+                    buffer.size * growthFactorPercent / 100, buffer.targetSize);
+                void* newPtr = BenchmarkReallocate(buffer.ptr, buffer.size, newSize);
+                if (newPtr == buffer.ptr) {
+                    ++inPlaceReallocs;
+                } else {
+                    ++movedReallocs;
+                    bytesCopied += buffer.size;
+                }
+
+                buffer.ptr = newPtr;
+                buffer.size = newSize;
+                *(static_cast<char*>(buffer.ptr) + newSize - 1) = 1;
+
+                if (buffer.size == buffer.targetSize) {
+                    --buffersLeft;
+                    if (buffer.shrink) {
+                        std::size_t shrunkSize =
+                            std::max<std::size_t>(buffer.size / g_vectorGrowthShrinkFactor, 1);
+                        newPtr = BenchmarkReallocate(buffer.ptr, buffer.size, shrunkSize);
+                        if (newPtr == buffer.ptr) {
+                            ++inPlaceReallocs;
+                        } else {
+                            ++movedReallocs;
+                            bytesCopied += shrunkSize;
+                        }
+                        buffer.ptr = newPtr;
+                        buffer.size = buffer.targetSize = shrunkSize;
+                    }
+                }
+            }
+        }
+
+        for (auto& buffer : buffers)
+            BenchmarkDeallocate(buffer.ptr);
+    }
+    memorySampler.Stop();
+
+    state.SetLabel(BenchmarkAllocatorHas(kBenchmarkCapNativeReallocate) ? "native-realloc"
+                                                                         : "fallback-realloc");
+    state.counters["InPlaceReallocs"] =
+        benchmark::Counter(inPlaceReallocs, benchmark::Counter::kAvgIterations);
+    state.counters["MovedReallocs"] =
+        benchmark::Counter(movedReallocs, benchmark::Counter::kAvgIterations);
+    state.counters["BytesCopied"] = benchmark::Counter(bytesCopied,
+                                                       benchmark::Counter::kAvgIterations,
+                                                       benchmark::Counter::OneK::kIs1024);
+    state.counters["InPlaceRatio"] = static_cast<double>(inPlaceReallocs) /
+                                     std::max<uint64_t>(inPlaceReallocs + movedReallocs, 1);
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    memorySampler.Export(state);
+}
+
+BENCHMARK(BM_VectorGrowth)
+    ->ArgNames({ "buffers", "growth%" })
+    ->ArgsProduct({ { 32, 256 }, { 150, 200 } })
+    ->Unit(benchmark::kMillisecond);
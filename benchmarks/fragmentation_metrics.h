@@ -0,0 +1,87 @@
+#pragma once
+
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_utils.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace bm::utils {
+    /**
+     * @brief Compares live requested bytes (tracked by the benchmark) with what the process and
+     * the allocator actually hold. Each Sample() computes:
+     *  - live / RSS (whole process, so it includes benchmark bookkeeping),
+     *  - live / allocator active bytes (internal fragmentation and per-chunk overhead),
+     *  - live / allocator mapped bytes (additionally free and cached memory).
+     * A ratio of 1 means no overhead at all. Mean and minimum over all samples are exported.
+     */
+    class FragmentationMetrics
+    {
+    public:
+        /**
+         * @brief Takes a sample. Reads /proc/self/statm and allocator statistics, so it should be
+         * called a handful of times per benchmark run, not per operation.
+         * @param t_liveBytes Currently live requested bytes
+         */
+        void Sample(std::size_t t_liveBytes)
+        {
+            if (t_liveBytes == 0)
+                return;
+
+            m_rss.Add(t_liveBytes, GetProcCurrentMemoryUsage());
+
+            BenchmarkAllocatorStats stats;
+            if (BenchmarkAllocatorGetStats(stats)) {
+                m_active.Add(t_liveBytes, stats.activeBytes);
+                m_mapped.Add(t_liveBytes, stats.mappedBytes);
+            }
+        }
+
+        /**
+         * @brief Exports LiveToRss/LiveToActive/LiveToMapped (mean) and the same counters with a
+         * "Min" suffix. Ratios the allocator doesn't report are omitted.
+         */
+        void ExportCounters(benchmark::State& t_state) const
+        {
+            m_rss.Export(t_state, "LiveToRss");
+            m_active.Export(t_state, "LiveToActive");
+            m_mapped.Export(t_state, "LiveToMapped");
+        }
+
+    private:
+        struct Ratio
+        {
+            double sum = 0;
+            double min = std::numeric_limits<double>::max();
+            uint32_t totalSamples = 0;
+
+            void Add(std::size_t t_live, std::size_t t_held)
+            {
+                if (t_held == 0)
+                    return;
+
+                double ratio = static_cast<double>(t_live) / t_held;
+                sum += ratio;
+                min = std::min(min, ratio);
+                ++totalSamples;
+            }
+
+            void Export(benchmark::State& t_state, const std::string& t_prefix) const
+            {
+                if (totalSamples == 0)
+                    return;
+
+                t_state.counters[t_prefix] = sum / totalSamples;
+                t_state.counters[t_prefix + "Min"] = min;
+            }
+        };
+
+        Ratio m_rss;
+        Ratio m_active;
+        Ratio m_mapped;
+    };
+}
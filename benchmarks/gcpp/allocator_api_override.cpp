@@ -1,16 +1,167 @@
+#include "allocator_api_fallback.h"
 #include "allocator_api_override.h"
-#include "gcpp/gpage_allocator.h"
+#include "allocator_profiles.h"
 #include "gcpp/deferred_heap.h"
 
-void BenchmarkAllocatorInitialize() { return; }
-void BenchmarkAllocatorFinalize() { return; }
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
 
-void* BenchmarkAllocate(std::size_t t_size) {
-    return nullptr;
-    // return heap.allocate<char>(t_size);
+namespace {
+    //! @brief Allocation granule, keeps chunks (and the header in front of them) 16 byte aligned
+    struct alignas(16) Granule
+    {
+        unsigned char bytes[16];
+    };
+
+    //! @brief Stored in the granule in front of every chunk
+    struct ChunkHeader
+    {
+        //! @brief Index of the root in g_roots that keeps the chunk alive
+        std::size_t rootIdx;
+        std::size_t size;
+    };
+    static_assert(sizeof(ChunkHeader) <= sizeof(Granule));
+
+    std::unique_ptr<gcpp::deferred_heap> g_heap;
+
+    /**
+     * @brief deferred_heap has no explicit free: memory is reclaimed by collect() once nothing
+     * points to it. Every chunk handed out through the shim is owned by a root here, and freeing
+     * it just drops that root.
+     */
+    std::vector<gcpp::deferred_ptr<Granule>> g_roots;
+    std::vector<std::size_t> g_vacantRoots;
+
+    //! @brief Bytes dropped since the last collect()
+    std::size_t g_garbageBytes = 0;
+    //! @brief collect() is triggered once this many bytes were dropped
+    std::size_t g_collectThreshold = 64 * 1024 * 1024;
+
+    inline ChunkHeader* GetHeader(void* t_ptr)
+    {
+        return reinterpret_cast<ChunkHeader*>(static_cast<Granule*>(t_ptr) - 1);
+    }
+}
+
+bool BenchmarkAllocatorInitialize(const char* t_profile)
+{
+    if (!bm::profiles::IsDefault(t_profile))
+        return false;
+
+    // Roots must go away before the heap they point into
+    g_roots.clear();
+    g_vacantRoots.clear();
+    g_garbageBytes = 0;
+    g_heap = std::make_unique<gcpp::deferred_heap>();
+
+    if (const char* threshold = std::getenv("MPP_BENCH_GCPP_COLLECT_BYTES"))
+        g_collectThreshold = std::strtoull(threshold, nullptr, 10);
+    return true;
+}
+
+const char* const* BenchmarkAllocatorProfiles()
+{
+    return bm::profiles::DefaultOnly();
+}
+
+void BenchmarkAllocatorFinalize()
+{
+    g_roots.clear();
+    g_vacantRoots.clear();
+    g_heap.reset();
+}
+
+void* BenchmarkAllocate(std::size_t t_size)
+{
+    std::size_t granules = (t_size + sizeof(Granule) - 1) / sizeof(Granule) + 1;
+    gcpp::deferred_ptr<Granule> chunk = g_heap->make_array<Granule>(granules);
+    if (chunk.get() == nullptr)
+        return nullptr;
+
+    std::size_t rootIdx;
+    if (!g_vacantRoots.empty()) {
+        rootIdx = g_vacantRoots.back();
+        g_vacantRoots.pop_back();
+        g_roots[rootIdx] = chunk;
+    } else {
+        rootIdx = g_roots.size();
+        g_roots.push_back(chunk);
+    }
+
+    Granule* ptr = chunk.get() + 1;
+    *GetHeader(ptr) = ChunkHeader{ rootIdx, t_size };
+    return ptr;
+}
+
+void BenchmarkDeallocate(void* t_ptr)
+{
+    if (t_ptr == nullptr)
+        return;
+
+    // Copied, dropping the root may release the chunk
+    ChunkHeader header = *GetHeader(t_ptr);
+    g_garbageBytes += header.size;
+    g_roots[header.rootIdx].reset();
+    g_vacantRoots.push_back(header.rootIdx);
+
+    if (g_garbageBytes >= g_collectThreshold) {
+        g_heap->collect();
+        g_garbageBytes = 0;
+    }
+}
+
+void BenchmarkThreadInitialize()
+{
+    return;
 }
 
-void BenchmarkDeallocate(void* t_ptr) {
+void BenchmarkThreadFinalize()
+{
     return;
-    // gcpp::page.deallocate((gcpp::byte*)t_ptr);
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    // deferred_heap is not synchronized, everything goes through the generic fallbacks
+    return 0;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return bm::fallback::Reallocate(t_ptr, t_oldSize, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    return nullptr;
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return bm::fallback::AllocateZeroed(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    bm::fallback::DeallocateSized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    return (GetHeader(t_ptr)->size + sizeof(Granule) - 1) / sizeof(Granule) * sizeof(Granule);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+    return false;
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    // collect() is the only way deferred_heap releases anything
+    g_heap->collect();
+    g_garbageBytes = 0;
+    return true;
 }
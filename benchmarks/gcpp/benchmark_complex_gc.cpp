@@ -0,0 +1,593 @@
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "gcpp/deferred_heap.h"
+#include "latency_histogram.h"
+#include "memory_sampler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief gcpp port of the memplusplus WorkerGC graph workload (mempp/benchmark_complex_gc.cpp):
+ * same operations, transition matrices and random sequences, on gcpp::deferred_ptr inside a
+ * gcpp::deferred_heap. deferred_heap is not thread-safe, so only the single-mutator benchmark
+ * is ported.
+ */
+class WorkerGC
+{
+public:
+    //! @brief Default transition matrix
+    static constexpr std::array<std::array<float, 7>, 7> c_defaultTransitionMatrix{
+        std::array<float,
+                   7>{ 0.4040, 0.0200, 0.250, 0.020, 0.240, 0.0650, 0.0010 }, /* CREATE_VERTEX */
+        std::array<float,
+                   7>{ 0.1200, 0.4470, 0.150, 0.250, 0.020, 0.0090, 0.0040 }, /* REMOVE_VERTEX */
+        std::array<float,
+                   7>{ 0.1800, 0.1000, 0.380, 0.010, 0.300, 0.0290, 0.0010 }, /* CREATE_EDGE */
+        std::array<float,
+                   7>{ 0.1700, 0.3200, 0.127, 0.280, 0.043, 0.0530, 0.0070 }, /* REMOVE_EDGE */
+        std::array<float,
+                   7>{ 0.1016, 0.2090, 0.130, 0.150, 0.200, 0.2090, 0.0004 }, /* WRITE_DATA */
+        std::array<float,
+                   7>{ 0.1400, 0.1990, 0.110, 0.150, 0.200, 0.2000, 0.0010 }, /* READ_DATA  */
+        std::array<float,
+                   7>{ 0.3500, 0.0500, 0.350, 0.050, 0.099, 0.1009, 0.0001 }, /* COLLECT_GARBAGE */
+    };
+
+    static constexpr uint32_t c_maxPointersInAVertex = 32;
+
+    //! @brief Enum with all possible operations.
+    enum class Operation
+    {
+        CREATE_VERTEX = 0,
+        REMOVE_VERTEX,
+        CREATE_EDGE,
+        REMOVE_EDGE,
+        WRITE_DATA,
+        READ_DATA,
+        COLLECT_GARBAGE,
+        COUNT,
+        INVALID
+    };
+
+    class Vertex
+    {
+    private:
+        std::array<gcpp::deferred_ptr<Vertex>, c_maxPointersInAVertex> m_gcs;
+        uint64_t m_data;
+
+    public:
+        Vertex()
+            : m_data(0x13371337deadbeef)
+        {}
+
+        void AddPointer(const gcpp::deferred_ptr<Vertex>& t_ptr)
+        {
+            auto vacant = std::find_if(
+                m_gcs.begin(), m_gcs.end(), [](const gcpp::deferred_ptr<Vertex>& t_ptr) {
+                    return t_ptr.get() == nullptr;
+                });
+
+            if (vacant != m_gcs.end()) {
+                *vacant = t_ptr;
+            }
+        }
+
+        std::array<gcpp::deferred_ptr<Vertex>, c_maxPointersInAVertex>& GetPointers()
+        {
+            return m_gcs;
+        }
+
+        void RemovePointer()
+        {
+            auto pointerLoc = std::find_if(
+                m_gcs.begin(), m_gcs.end(), [](const gcpp::deferred_ptr<Vertex>& t_ptr) {
+                    return t_ptr.get() != nullptr;
+                });
+
+            if (pointerLoc != m_gcs.end()) {
+                pointerLoc->reset();
+            }
+        }
+
+        uint64_t& GetData()
+        {
+            return m_data;
+        }
+    };
+
+    /**
+     * @brief Construct a new WorkerGC object
+     * @param t_heap Heap to allocate vertices on, must outlive the worker
+     * @param t_totalOps The total number of loop iterations to perform
+     * @param t_transitionMatrix The transition matrix
+     * @param t_xorshiftSeed The seed for the xorshift random number generator
+     * @param t_totalVertices Number of vertex slots
+     */
+    WorkerGC(gcpp::deferred_heap& t_heap,
+             uint32_t t_totalOps = 1024 * 128,
+             std::array<std::array<float, 7>, 7> t_transitionMatrix = c_defaultTransitionMatrix,
+             uint64_t t_xorshiftSeed = g_gcXorshiftSeed,
+             uint32_t t_totalVertices = 1024)
+        : m_heap(t_heap)
+        , m_activePtrs(t_totalVertices)
+        , m_totalOps(t_totalOps)
+        , m_transitionMatrix(t_transitionMatrix)
+    {
+        m_transitionsRngState = bm::utils::XorshiftNext(t_xorshiftSeed);
+        m_defaultRngState = bm::utils::XorshiftNext(t_xorshiftSeed);
+
+        CheckTransitionMatrix();
+        CreateRandomGraph();
+
+        m_liveVertices = CountReachableVertices();
+        m_verticesCreatedSinceGc = 0;
+    }
+
+    //! @brief A single collect() call.
+    struct GcRecord
+    {
+        double pauseNs;
+        //! @brief Bytes of vertices on the heap before the collection (live and garbage).
+        std::size_t heapBytesBefore;
+        //! @brief Bytes of vertices reachable from the roots after the collection.
+        std::size_t liveBytesAfter;
+    };
+
+    struct BenchResults
+    {
+        //! @brief Total iterations count.
+        uint32_t totalIterations;
+
+        //! @brief Number of calls to collect().
+        uint32_t totalGcInvocations;
+
+        //! @brief Time spent inside collect() (ns).
+        double gcTimeNs;
+    };
+
+    /**
+     * @brief Runs the benchmark.
+     * @return BenchResults - total number of iterations, number of collections, time spent
+     * collecting.
+     */
+    BenchResults RunBenchmark()
+    {
+        while (m_ops <= m_totalOps) {
+            ++m_ops;
+            PerformOperation(GetNextOperation());
+        }
+
+        return BenchResults{ m_ops,
+                             static_cast<uint32_t>(m_totalGcInvocations),
+                             m_gcTicks / bm::utils::GetTimestampTicksPerNs() };
+    }
+
+    //! @brief Durations of all collect() calls (ticks).
+    const bm::utils::LatencyHistogram& GetGcPauses() const
+    {
+        return m_gcPauses;
+    }
+
+    //! @brief Per-collection heap sizes.
+    const std::vector<GcRecord>& GetGcRecords() const
+    {
+        return m_gcRecords;
+    }
+
+    //! @brief Time spent computing GcRecord heap sizes, to be excluded from the measured time.
+    double GetInstrumentationTimeNs() const
+    {
+        return m_instrumentationTicks / bm::utils::GetTimestampTicksPerNs();
+    }
+
+private:
+    //! @brief Heap all vertices live on
+    gcpp::deferred_heap& m_heap;
+
+    //! @brief Vector of pointers to allocated memory (roots)
+    std::vector<gcpp::deferred_ptr<Vertex>> m_activePtrs;
+
+    //! @brief Total operations to perform
+    uint32_t m_totalOps;
+
+    //! @brief Number of switch-cases executed
+    uint32_t m_ops = 0;
+
+    //! @brief Total number of GC invocations
+    uint64_t m_totalGcInvocations = 0;
+
+    //! @brief Ticks spent inside collect()
+    uint64_t m_gcTicks = 0;
+
+    //! @brief Durations of all collect() calls
+    bm::utils::LatencyHistogram m_gcPauses;
+
+    //! @brief Heap sizes around every collect() call
+    std::vector<GcRecord> m_gcRecords;
+
+    //! @brief Vertices reachable from the roots after the last collection
+    std::size_t m_liveVertices = 0;
+
+    //! @brief Vertices allocated since the last collection
+    std::size_t m_verticesCreatedSinceGc = 0;
+
+    //! @brief Ticks spent computing GcRecord heap sizes
+    uint64_t m_instrumentationTicks = 0;
+
+    //! @brief Random number generator state for transitions
+    uint64_t m_transitionsRngState;
+
+    //! @brief Default random number generator state
+    uint64_t m_defaultRngState;
+
+    //! @brief Current statemachine state
+    Operation m_currentOp = Operation::CREATE_VERTEX;
+
+    //! @brief Transition matrix with probabilities of switching to another state
+    std::array<std::array<float, 7>, 7> m_transitionMatrix;
+
+    //! @brief Performs a single graph operation
+    void PerformOperation(Operation t_op)
+    {
+        switch (t_op) {
+            case Operation::CREATE_VERTEX: {
+                CreateVertexIfDoesntExist();
+                break;
+            }
+            case Operation::REMOVE_VERTEX: {
+                m_activePtrs.at(GetActivePtrsRandIdx()).reset();
+                break;
+            }
+            case Operation::CREATE_EDGE: {
+                auto vtx_to_add = GetRandomActivePtr();
+                auto vtx_add_to = GetRandomActivePtr();
+
+                if (!vtx_to_add.has_value() || !vtx_add_to.has_value()) {
+                    return;
+                }
+
+                vtx_add_to.value().get()->AddPointer(vtx_to_add.value().get());
+                break;
+            }
+            case Operation::REMOVE_EDGE: {
+                auto vertex = GetRandomActivePtr();
+                if (!vertex.has_value()) {
+                    return;
+                }
+
+                vertex.value().get()->RemovePointer();
+                break;
+            }
+            case Operation::WRITE_DATA: {
+                auto vertex = GetRandomActivePtr();
+                if (!vertex.has_value()) {
+                    return;
+                }
+
+                vertex.value().get()->GetData() =
+                    bm::utils::XorshiftNext(m_defaultRngState, (uint64_t)0, 0xdeadbeef);
+                break;
+            }
+            case Operation::READ_DATA: {
+                auto vertex = GetRandomActivePtr();
+                if (!vertex.has_value()) {
+                    return;
+                }
+
+                volatile auto data = vertex.value().get()->GetData();
+                break;
+            }
+            case Operation::COLLECT_GARBAGE: {
+                m_totalGcInvocations++;
+                uint64_t gcStart = bm::utils::ReadTimestamp();
+                m_heap.collect();
+                uint64_t gcTicks = bm::utils::ReadTimestamp() - gcStart;
+                m_gcTicks += gcTicks;
+                m_gcPauses.Record(gcTicks);
+                RecordCollection(gcTicks);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    /**
+     * @brief Appends a GcRecord for the collection that just finished. deferred_heap reclaims
+     * everything unreachable on collect(), so the same accounting as for memplusplus holds.
+     */
+    void RecordCollection(uint64_t t_pauseTicks)
+    {
+        uint64_t start = bm::utils::ReadTimestamp();
+        std::size_t heapVerticesBefore = m_liveVertices + m_verticesCreatedSinceGc;
+        m_liveVertices = CountReachableVertices();
+        m_verticesCreatedSinceGc = 0;
+        m_gcRecords.push_back(GcRecord{ t_pauseTicks / bm::utils::GetTimestampTicksPerNs(),
+                                        heapVerticesBefore * sizeof(Vertex),
+                                        m_liveVertices * sizeof(Vertex) });
+        m_instrumentationTicks += bm::utils::ReadTimestamp() - start;
+    }
+
+    //! @brief Counts distinct vertices reachable from m_activePtrs.
+    std::size_t CountReachableVertices() const
+    {
+        std::unordered_set<const Vertex*> visited;
+        std::vector<Vertex*> stack;
+        for (auto& root : m_activePtrs) {
+            if (root.get() != nullptr && visited.insert(root.get()).second)
+                stack.push_back(root.get());
+        }
+
+        while (!stack.empty()) {
+            Vertex* vertex = stack.back();
+            stack.pop_back();
+            for (auto& ptr : vertex->GetPointers()) {
+                if (ptr.get() != nullptr && visited.insert(ptr.get()).second)
+                    stack.push_back(ptr.get());
+            }
+        }
+
+        return visited.size();
+    }
+
+    gcpp::deferred_ptr<Vertex>& CreateVertexAtIdxIfDoesntExist(uint32_t i)
+    {
+        if (m_activePtrs.at(i).get() == nullptr) {
+            return CreateVertexAtIdx(i);
+        }
+
+        return m_activePtrs[i];
+    }
+
+    gcpp::deferred_ptr<Vertex>& CreateVertexAtIdx(uint32_t i)
+    {
+        m_activePtrs[i] = m_heap.make<Vertex>();
+        ++m_verticesCreatedSinceGc;
+        return m_activePtrs[i];
+    }
+
+    gcpp::deferred_ptr<Vertex>& CreateVertexIfDoesntExist()
+    {
+        uint32_t idx = GetActivePtrsRandIdx();
+
+        if (m_activePtrs.at(idx).get() == nullptr) {
+            return CreateVertexAtIdx(idx);
+        }
+
+        return m_activePtrs[idx];
+    }
+
+    std::optional<std::reference_wrapper<gcpp::deferred_ptr<Vertex>>> GetRandomActivePtr()
+    {
+        uint32_t vtxIdx1 = GetActivePtrsRandIdx();
+        gcpp::deferred_ptr<Vertex>& vertex = m_activePtrs[vtxIdx1];
+        if (vertex.get() == nullptr) {
+            auto loc = std::find_if(
+                m_activePtrs.begin(),
+                m_activePtrs.end(),
+                [](const gcpp::deferred_ptr<Vertex>& t_ptr) { return t_ptr.get() != nullptr; });
+
+            if (loc == m_activePtrs.end()) {
+                return {};
+            }
+
+            vertex = *loc;
+        }
+
+        return vertex;
+    }
+
+    inline uint32_t GetActivePtrsRandIdx()
+    {
+        return bm::utils::XorshiftNext(m_transitionsRngState, 0, m_activePtrs.size() - 1);
+    }
+
+    //! @brief Checks if transition matrix is valid
+    void CheckTransitionMatrix()
+    {
+        for (uint32_t rowIdx = 0; rowIdx < m_transitionMatrix.size(); ++rowIdx) {
+            float sum = 0.0f;
+            for (auto& col : m_transitionMatrix[rowIdx]) {
+                sum += col;
+            }
+
+            if (sum <= 0.99999f || sum >= 1.00001f) {
+                throw std::runtime_error("Transition matrix row: " + std::to_string(rowIdx) +
+                                         " is invalid. The sum is: " + std::to_string(sum));
+            }
+        }
+    }
+
+    //! @brief Performs transition to another state
+    Operation GetNextOperation()
+    {
+        auto& row = m_transitionMatrix[static_cast<uint32_t>(m_currentOp)];
+        auto rand = bm::utils::XorshiftNext(m_transitionsRngState, 0.0f, 1.0f);
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < row.size(); ++i) {
+            sum += row[i];
+            if (rand < sum) {
+                m_currentOp = static_cast<Operation>(i);
+                return m_currentOp;
+            }
+        }
+
+        return Operation::INVALID;
+    }
+
+    void CreateRandomGraph(const float t_graphDensity = 0.7,
+                           const float t_vertexDensityFactor = 0.8,
+                           const uint32_t t_totalSubgraphs = 9)
+    {
+        for (uint32_t clusterIdx = 0; clusterIdx < t_totalSubgraphs; clusterIdx++) {
+            const uint32_t verticesInACluster = m_activePtrs.size() / t_totalSubgraphs;
+            const uint32_t clusterStart = verticesInACluster * clusterIdx;
+            const uint32_t clusterEnd = clusterStart + verticesInACluster;
+
+            for (uint32_t i = clusterStart; i < clusterEnd; i++) {
+                if (bm::utils::XorshiftNext(m_defaultRngState, 0.0f, 1.0f) > t_graphDensity) {
+                    m_activePtrs[i] = m_heap.make<Vertex>();
+                    ++m_verticesCreatedSinceGc;
+                    auto& vertexAdjList = m_activePtrs[i]->GetPointers();
+
+                    for (uint32_t j = 0; j < vertexAdjList.size(); j++) {
+                        if (bm::utils::XorshiftNext(m_defaultRngState, 0.0f, 1.0f) >
+                            t_vertexDensityFactor) {
+                            uint32_t otherVtxIdx = bm::utils::XorshiftNext(
+                                m_defaultRngState, static_cast<uint64_t>(clusterStart), clusterEnd);
+                            auto& otherVertex = CreateVertexAtIdxIfDoesntExist(otherVtxIdx);
+                            vertexAdjList[j] = otherVertex;
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief Appends per-collection records to the MPP_BENCH_GC_LOG CSV file (if configured). Same
+ * columns as the memplusplus target, gcpp has no GC pointer counts so those are left empty.
+ */
+static void AppendGcLog(const std::string& t_name,
+                        uint64_t t_iteration,
+                        const std::vector<WorkerGC::GcRecord>& t_records)
+{
+    const char* path = std::getenv("MPP_BENCH_GC_LOG");
+    if (path == nullptr)
+        return;
+
+    std::ofstream log(path, std::ios::app);
+    if (log.tellp() == 0) {
+        log << "benchmark,iteration,collection,pause_ns,heap_bytes_before,live_bytes_after,"
+               "reclaimed_bytes,gc_ptrs_before,gc_ptrs_after\n";
+    }
+
+    for (std::size_t i = 0; i < t_records.size(); ++i) {
+        const auto& record = t_records[i];
+        log << t_name << ',' << t_iteration << ',' << i << ',' << record.pauseNs << ','
+            << record.heapBytesBefore << ',' << record.liveBytesAfter << ','
+            << record.heapBytesBefore - record.liveBytesAfter << ",,\n";
+    }
+}
+
+/**
+ * @brief gcpp version of the memplusplus BM_ComplexGc (same names and counters, so results of
+ * both targets can be compared directly). Every collect() call is timed (GcPause* counters) and
+ * the heap is measured around it. Heap measurement time is excluded from the iteration time.
+ */
+template<class... Args>
+static void BM_ComplexGc(benchmark::State& state, Args&&... args)
+{
+    auto argsTuple = std::make_tuple(std::move(args)...);
+    auto totalOps = std::get<0>(argsTuple);
+    auto transitionMatrix = std::get<1>(argsTuple);
+    const std::string name = "BM_ComplexGc/" + std::to_string(totalOps);
+
+    WorkerGC::BenchResults result;
+    bm::utils::LatencyHistogram gcPauses;
+    std::size_t totalCollections = 0;
+    double heapBytesBefore = 0;
+    double liveBytesAfter = 0;
+    uint64_t iteration = 0;
+
+    bm::utils::MemorySampler memorySampler(name);
+    memorySampler.Start();
+    for (auto _ : state) {
+        gcpp::deferred_heap heap;
+        WorkerGC workergc(heap, totalOps, transitionMatrix);
+        auto start = std::chrono::high_resolution_clock::now();
+        result = workergc.RunBenchmark();
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+        state.SetIterationTime(duration.count() - workergc.GetInstrumentationTimeNs() / 1e9);
+
+        gcPauses.Merge(workergc.GetGcPauses());
+        for (auto& record : workergc.GetGcRecords()) {
+            heapBytesBefore += record.heapBytesBefore;
+            liveBytesAfter += record.liveBytesAfter;
+        }
+        totalCollections += workergc.GetGcRecords().size();
+        AppendGcLog(name, iteration++, workergc.GetGcRecords());
+    }
+    memorySampler.Stop();
+
+    state.counters["TotalControlLoopIterations"] = result.totalIterations;
+    state.counters["TotalGcInvocations"] = result.totalGcInvocations;
+    gcPauses.ExportCounters(state, "GcPause");
+    if (totalCollections != 0) {
+        state.counters["GcHeapBytesBefore"] = heapBytesBefore / totalCollections;
+        state.counters["GcLiveBytesAfter"] = liveBytesAfter / totalCollections;
+        state.counters["GcReclaimedBytes"] = (heapBytesBefore - liveBytesAfter) / totalCollections;
+    }
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    memorySampler.Export(state);
+}
+
+#define BENCHMARK_WITH_MATRIX(name, iters, transitions)                                            \
+    BENCHMARK_CAPTURE(BM_ComplexGc, name, (iters), (transitions))                                  \
+        ->Unit(benchmark::kMillisecond)                                                            \
+        ->Iterations(7)                                                                            \
+        ->UseManualTime()
+
+#define BENCHMARK_SIMULATE_NORM_WORKLOAD(iters)                                                    \
+    BENCHMARK_WITH_MATRIX(                                                                         \
+        "Total ops: " #iters "Transition matrix: norm-workload",                                   \
+        iters,                                                                                     \
+        (std::array<std::array<float, 7>, 7>{                                                      \
+            std::array<float, 7>{                                                                  \
+                0.404, 0.02, 0.25, 0.02, 0.240, 0.065, 0.001 }, /* CREATE_VERTEX */                \
+            std::array<float, 7>{                                                                  \
+                0.12, 0.447, 0.15, 0.25, 0.020, 0.009, 0.004 }, /* REMOVE_VERTEX */                \
+            std::array<float, 7>{                                                                  \
+                0.18, 0.100, 0.38, 0.01, 0.300, 0.029, 0.001 }, /* CREATE_EDGE */                  \
+            std::array<float, 7>{                                                                  \
+                0.17, 0.32, 0.127, 0.28, 0.043, 0.053, 0.007 }, /* REMOVE_EDGE */                  \
+            std::array<float, 7>{                                                                  \
+                0.1016, 0.209, 0.13, 0.15, 0.20, 0.209, 0.0004 }, /* WRITE_DATA */                 \
+            std::array<float, 7>{                                                                  \
+                0.140, 0.1990, 0.110, 0.150, 0.20, 0.20, 0.001 }, /* READ_DATA */                  \
+            std::array<float, 7>{                                                                  \
+                0.35, 0.05, 0.35, 0.05, 0.099, 0.1009, 0.0001 }, /* COLLECT_GARBAGE */             \
+        }))
+
+#define BENCHMARK_SIMULATE_GC_HEAVY(iters)                                                         \
+    BENCHMARK_WITH_MATRIX(                                                                         \
+        "Total ops: " #iters "Transition matrix: gc-heavy",                                        \
+        iters,                                                                                     \
+        (std::array<std::array<float, 7>, 7>{                                                      \
+            std::array<float, 7>{                                                                  \
+                0.404, 0.02, 0.25, 0.02, 0.237, 0.060, 0.009 }, /* CREATE_VERTEX */                \
+            std::array<float, 7>{                                                                  \
+                0.12, 0.445, 0.15, 0.25, 0.020, 0.009, 0.006 }, /* REMOVE_VERTEX */                \
+            std::array<float, 7>{                                                                  \
+                0.18, 0.100, 0.38, 0.01, 0.297, 0.029, 0.004 },                 /* CREATE_EDGE */  \
+            std::array<float, 7>{ 0.17, 0.29, 0.127, 0.25, 0.043, 0.05, 0.07 }, /* REMOVE_EDGE */  \
+            std::array<float, 7>{                                                                  \
+                0.1016, 0.209, 0.13, 0.15, 0.20, 0.209, 0.0004 }, /* WRITE_DATA */                 \
+            std::array<float, 7>{                                                                  \
+                0.140, 0.1990, 0.110, 0.150, 0.20, 0.20, 0.001 }, /* READ_DATA */                  \
+            std::array<float, 7>{                                                                  \
+                0.35, 0.05, 0.35, 0.05, 0.099, 0.1009, 0.0001 }, /* COLLECT_GARBAGE */             \
+        }))                                                                                        \
+        ->Iterations(5)
+
+BENCHMARK_SIMULATE_NORM_WORKLOAD(50'000);
+BENCHMARK_SIMULATE_NORM_WORKLOAD(100'000);
+
+BENCHMARK_SIMULATE_GC_HEAVY(50'000);
+BENCHMARK_SIMULATE_GC_HEAVY(100'000);
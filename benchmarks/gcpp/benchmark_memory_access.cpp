@@ -0,0 +1,145 @@
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "gcpp/deferred_heap.h"
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/**
+ * @brief gcpp port of the memplusplus linked list access benchmark
+ * (mempp/benchmark_memory_access.cpp). deferred_heap doesn't move objects, so unlike
+ * memplusplus, collect() can't improve the layout: the "Layouted" variants show what a
+ * non-compacting collection leaves behind.
+ */
+template<bool RandomizedLinkedList, bool DoLayout = false>
+class Worker
+{
+public:
+    Worker(benchmark::State& t_bmState,
+           uint32_t t_LinkedListSize,
+           uint64_t t_xorshiftSeed = 0x133796A5FF21B3C1)
+        : m_bmState(t_bmState)
+        , m_LinkedListSize(t_LinkedListSize)
+        , m_xorshiftSeed(t_xorshiftSeed)
+    {
+        if constexpr (RandomizedLinkedList) {
+            m_LinkedListHead = CreateRandomizedLinkedList(t_LinkedListSize);
+        } else {
+            m_LinkedListHead = CreateLayoutedLinkedList(t_LinkedListSize);
+        }
+
+        if constexpr (DoLayout) {
+            m_heap.collect();
+        }
+    }
+
+    Worker(const Worker&) = delete;
+    Worker(Worker&&) = delete;
+    Worker& operator=(const Worker&) = delete;
+    Worker& operator=(Worker&&) = delete;
+    ~Worker() = default;
+
+    uint32_t DoBenchmark()
+    {
+        ListNode* current = m_LinkedListHead.get();
+
+        while (current->next.get() != nullptr) {
+            current->data = current->data ^ 0x1337AF12 ^ current->next->data;
+            current = current->next.get();
+        }
+
+        return current->data;
+    }
+
+private:
+    struct alignas(64) ListNode
+    {
+        uint32_t index;
+        uint32_t data;
+        gcpp::deferred_ptr<ListNode> next;
+
+        ListNode(uint32_t t_index, uint32_t t_data)
+            : index(t_index)
+            , data(t_data)
+            , next(nullptr)
+        {}
+    };
+
+    // Declared first, so that the list (roots into it) is destroyed before the heap
+    gcpp::deferred_heap m_heap;
+    benchmark::State& m_bmState;
+    uint32_t m_LinkedListSize;
+    uint64_t m_xorshiftSeed;
+    gcpp::deferred_ptr<ListNode> m_LinkedListHead;
+
+    gcpp::deferred_ptr<ListNode> CreateLayoutedLinkedList(uint32_t size)
+    {
+        uint32_t data = 0xF7ADF3E1;
+        gcpp::deferred_ptr<ListNode> head = m_heap.make<ListNode>(0, data);
+        gcpp::deferred_ptr<ListNode> current = head;
+
+        for (uint32_t i = 1; i < size; ++i) {
+            data = (data + 0xffffd) % ((2 << 20) + 1);
+            current->next = m_heap.make<ListNode>(i, data);
+            current = current->next;
+        }
+
+        return head;
+    }
+
+    gcpp::deferred_ptr<ListNode> CreateRandomizedLinkedList(uint32_t size)
+    {
+        std::vector<gcpp::deferred_ptr<ListNode>> nodes;
+        nodes.reserve(size);
+        uint32_t data = 0xF7ADF3E1;
+
+        for (uint32_t i = 0; i < size; ++i) {
+            data = (data + 0xffffd) % ((2 << 20) + 1);
+            nodes.emplace_back(m_heap.make<ListNode>(i, data));
+        }
+
+        std::shuffle(std::begin(nodes), std::end(nodes), std::minstd_rand(m_xorshiftSeed));
+
+        for (uint32_t i = 0; i < size - 1; ++i) {
+            nodes[i]->next = nodes[i + 1];
+        }
+
+        return nodes[0];
+    }
+};
+
+#define BENCHMARK_MEM_ACCESS(BM_NAME, RANDOMIZED_LINKED_LIST, DO_LAYOUT)                           \
+    static void BM_NAME(benchmark::State& state)                                                   \
+    {                                                                                              \
+        Worker<RANDOMIZED_LINKED_LIST, DO_LAYOUT> worker(state, state.range(0));                   \
+        bm::utils::PerfCounters perfCounters;                                                      \
+        for (auto _ : state) {                                                                     \
+            auto start = std::chrono::high_resolution_clock::now();                                \
+            perfCounters.Start();                                                                  \
+            uint32_t tmp = worker.DoBenchmark();                                                   \
+            benchmark::DoNotOptimize(tmp);                                                         \
+            perfCounters.Stop();                                                                   \
+            auto end = std::chrono::high_resolution_clock::now();                                  \
+            auto duration =                                                                        \
+                std::chrono::duration_cast<std::chrono::duration<double>>(end - start);            \
+            state.SetIterationTime(duration.count());                                              \
+        }                                                                                          \
+        perfCounters.ExportCounters(state);                                                        \
+    }                                                                                              \
+    BENCHMARK(BM_NAME)                                                                             \
+        ->RangeMultiplier(2)                                                                       \
+        ->Range(g_accessMemoryRangeStart, g_accessMemoryRangeEnd)                                  \
+        ->Unit(benchmark::kMicrosecond)                                                            \
+        ->UseManualTime()
+
+BENCHMARK_MEM_ACCESS(BM_AccessMemoryDefaultLinkedList, false, false);
+BENCHMARK_MEM_ACCESS(BM_AccessMemoryRandomizedLinkedList, true, false);
+
+// collect() doesn't move objects, layouting is only attempted
+BENCHMARK_MEM_ACCESS(BM_AccessMemoryDefaultLayoutedLinkedList, false, true);
+BENCHMARK_MEM_ACCESS(BM_AccessMemoryRandomizedLayoutedLinkedList, true, true);
@@ -0,0 +1,89 @@
+#include "allocator_api_fallback.h"
+#include "allocator_api_override.h"
+#include "allocator_profiles.h"
+#include <cstdint>
+#include <cstdlib>
+#include <malloc.h>
+
+// libhoard.so interposes the libc allocation functions, everything below ends up in Hoard
+
+bool BenchmarkAllocatorInitialize(const char* t_profile)
+{
+    return bm::profiles::IsDefault(t_profile);
+}
+
+const char* const* BenchmarkAllocatorProfiles()
+{
+    return bm::profiles::DefaultOnly();
+}
+
+void BenchmarkAllocatorFinalize()
+{
+    return;
+}
+
+void* BenchmarkAllocate(std::size_t t_size)
+{
+    return malloc(t_size);
+}
+
+void BenchmarkDeallocate(void* t_ptr)
+{
+    free(t_ptr);
+}
+
+void BenchmarkThreadInitialize()
+{
+    return;
+}
+
+void BenchmarkThreadFinalize()
+{
+    return;
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    // Hoard has no sized free
+    return kBenchmarkCapThreadSafe | kBenchmarkCapNativeReallocate |
+           kBenchmarkCapNativeAllocateZeroed | kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return realloc(t_ptr, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, t_alignment, t_size) != 0)
+        return nullptr;
+    return ptr;
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return calloc(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    bm::fallback::DeallocateSized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    return malloc_usable_size(t_ptr);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+    // Hoard doesn't export statistics (mallinfo() would report glibc's unused heap)
+    return false;
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    return false;
+}
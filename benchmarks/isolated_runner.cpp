@@ -0,0 +1,498 @@
+#include "isolated_runner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace bm::utils {
+    namespace {
+        constexpr const char* c_isolateEnv = "MPP_BENCH_ISOLATE";
+        constexpr const char* c_benchmarksKey = "\"benchmarks\": [";
+
+        bool StartsWith(const std::string& t_str, const char* t_prefix)
+        {
+            return t_str.compare(0, std::strlen(t_prefix), t_prefix) == 0;
+        }
+
+        //! @brief Escapes a benchmark name, so that it can be matched by --benchmark_filter.
+        std::string EscapeRegex(const std::string& t_str)
+        {
+            std::string escaped;
+            for (char c : t_str) {
+                if (std::strchr("\\^$.|?*+()[]{}", c) != nullptr)
+                    escaped += '\\';
+                escaped += c;
+            }
+            return escaped;
+        }
+
+        /**
+         * @brief Executes the current binary with t_args (MPP_BENCH_ISOLATE is cleared for it).
+         * @param t_args Arguments without argv[0]
+         * @param t_stdout If not nullptr, receives everything the child printed to stdout
+         * @return Exit code of the child, 128 + signal number if it was killed
+         */
+        int RunChild(const std::string& t_self,
+                     const std::vector<std::string>& t_args,
+                     std::string* t_stdout)
+        {
+            std::vector<char*> argv;
+            argv.push_back(const_cast<char*>(t_self.c_str()));
+            for (auto& arg : t_args)
+                argv.push_back(const_cast<char*>(arg.c_str()));
+            argv.push_back(nullptr);
+
+            int pipeFds[2] = { -1, -1 };
+            if (t_stdout != nullptr && pipe(pipeFds) != 0)
+                return -1;
+
+            std::cout.flush();
+            std::fflush(nullptr);
+
+            pid_t pid = fork();
+            if (pid < 0)
+                return -1;
+
+            if (pid == 0) {
+                unsetenv(c_isolateEnv);
+                if (t_stdout != nullptr) {
+                    dup2(pipeFds[1], STDOUT_FILENO);
+                    close(pipeFds[0]);
+                    close(pipeFds[1]);
+                }
+                execv("/proc/self/exe", argv.data());
+                _exit(127);
+            }
+
+            if (t_stdout != nullptr) {
+                close(pipeFds[1]);
+                char buffer[4096];
+                ssize_t bytesRead;
+                while ((bytesRead = read(pipeFds[0], buffer, sizeof(buffer))) > 0)
+                    t_stdout->append(buffer, bytesRead);
+                close(pipeFds[0]);
+            }
+
+            int status = 0;
+            while (waitpid(pid, &status, 0) < 0) {
+                if (errno != EINTR)
+                    return -1;
+            }
+
+            if (WIFSIGNALED(status))
+                return 128 + WTERMSIG(status);
+            return WEXITSTATUS(status);
+        }
+
+        //! @brief Returns the contents of the "benchmarks" array of a JSON report, without [].
+        std::string ExtractBenchmarks(const std::string& t_json)
+        {
+            std::size_t begin = t_json.find(c_benchmarksKey);
+            std::size_t end = t_json.rfind(']');
+            if (begin == std::string::npos || end == std::string::npos || end < begin)
+                return {};
+
+            begin += std::strlen(c_benchmarksKey);
+            std::string body = t_json.substr(begin, end - begin);
+            body.erase(0, body.find_first_not_of(" \t\n"));
+            body.erase(body.find_last_not_of(" \t\n") + 1);
+            return body;
+        }
+
+        //! @brief Splits the contents of a "benchmarks" array into the JSON objects of the runs.
+        std::vector<std::string> SplitObjects(const std::string& t_benchmarks)
+        {
+            std::vector<std::string> objects;
+            std::size_t begin = 0;
+            int depth = 0;
+            bool inString = false;
+            for (std::size_t i = 0; i < t_benchmarks.size(); ++i) {
+                char c = t_benchmarks[i];
+                if (inString) {
+                    if (c == '\\')
+                        ++i;
+                    else if (c == '"')
+                        inString = false;
+                } else if (c == '"') {
+                    inString = true;
+                } else if (c == '{') {
+                    if (depth++ == 0)
+                        begin = i;
+                } else if (c == '}' && --depth == 0) {
+                    objects.push_back(t_benchmarks.substr(begin, i - begin + 1));
+                }
+            }
+            return objects;
+        }
+
+        //! @brief Fields of a run, in report order. Values are kept as raw JSON (strings quoted).
+        using RunFields = std::vector<std::pair<std::string, std::string>>;
+
+        //! @brief Parses a run object of the JSON reporter, which only has scalar fields.
+        RunFields ParseRun(const std::string& t_object)
+        {
+            RunFields fields;
+            std::size_t pos = 1;
+            while (true) {
+                std::size_t keyBegin = t_object.find('"', pos);
+                if (keyBegin == std::string::npos)
+                    break;
+                std::size_t keyEnd = t_object.find('"', keyBegin + 1);
+                std::size_t colon = t_object.find(':', keyEnd);
+                if (keyEnd == std::string::npos || colon == std::string::npos)
+                    break;
+
+                std::size_t valueBegin = t_object.find_first_not_of(" \t\n", colon + 1);
+                std::size_t valueEnd = valueBegin;
+                if (t_object[valueBegin] == '"') {
+                    for (++valueEnd; t_object[valueEnd] != '"'; ++valueEnd) {
+                        if (t_object[valueEnd] == '\\')
+                            ++valueEnd;
+                    }
+                    ++valueEnd;
+                } else {
+                    valueEnd = t_object.find_first_of(",}\n", valueBegin);
+                }
+
+                std::string value = t_object.substr(valueBegin, valueEnd - valueBegin);
+                value.erase(value.find_last_not_of(" \t") + 1);
+                fields.emplace_back(t_object.substr(keyBegin + 1, keyEnd - keyBegin - 1), value);
+                pos = valueEnd;
+            }
+            return fields;
+        }
+
+        std::string* FindField(RunFields& t_fields, const std::string& t_key)
+        {
+            for (auto& [key, value] : t_fields) {
+                if (key == t_key)
+                    return &value;
+            }
+            return nullptr;
+        }
+
+        void SetField(RunFields& t_fields, const std::string& t_key, const std::string& t_value)
+        {
+            if (std::string* value = FindField(t_fields, t_key))
+                *value = t_value;
+            else
+                t_fields.emplace_back(t_key, t_value);
+        }
+
+        std::string FormatRun(const RunFields& t_fields)
+        {
+            std::string object = "{";
+            for (std::size_t i = 0; i < t_fields.size(); ++i) {
+                object += (i ? ",\n      \"" : "\n      \"") + t_fields[i].first +
+                          "\": " + t_fields[i].second;
+            }
+            return object + "\n    }";
+        }
+
+        //! @return true if t_value is a JSON number, stored in t_number
+        bool ParseNumber(const std::string& t_value, double& t_number)
+        {
+            if (t_value.empty() || t_value[0] == '"')
+                return false;
+            char* end = nullptr;
+            t_number = std::strtod(t_value.c_str(), &end);
+            return *end == '\0';
+        }
+
+        std::string FormatNumber(double t_number)
+        {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.17g", t_number);
+            return buffer;
+        }
+
+        /**
+         * @brief Builds the mean, median and stddev aggregates of t_repetitions (runs of the same
+         * benchmark, one per child process), the same way google-benchmark aggregates
+         * repetitions. Runs that failed are left out.
+         */
+        std::vector<RunFields> AggregateRepetitions(std::vector<RunFields> t_repetitions)
+        {
+            t_repetitions.erase(std::remove_if(t_repetitions.begin(),
+                                               t_repetitions.end(),
+                                               [](RunFields& t_run) {
+                                                   std::string* error =
+                                                       FindField(t_run, "error_occurred");
+                                                   return error && *error == "true";
+                                               }),
+                                t_repetitions.end());
+            if (t_repetitions.size() < 2)
+                return {};
+
+            // Fields that describe the run instead of measuring it
+            constexpr const char* c_descriptive[] = {
+                "family_index", "per_family_instance_index", "repetitions", "repetition_index",
+                "threads",      "iterations"
+            };
+
+            std::vector<RunFields> aggregates;
+            for (const char* aggregate : { "mean", "median", "stddev" }) {
+                RunFields fields;
+                for (auto& [key, value] : t_repetitions.front()) {
+                    if (key == "repetition_index")
+                        continue;
+
+                    double number;
+                    bool descriptive =
+                        std::find_if(std::begin(c_descriptive),
+                                     std::end(c_descriptive),
+                                     [&](const char* t_key) { return key == t_key; }) !=
+                        std::end(c_descriptive);
+                    if (descriptive || !ParseNumber(value, number)) {
+                        fields.emplace_back(key, value);
+                        continue;
+                    }
+
+                    std::vector<double> values;
+                    for (auto& repetition : t_repetitions) {
+                        std::string* repetitionValue = FindField(repetition, key);
+                        if (repetitionValue && ParseNumber(*repetitionValue, number))
+                            values.push_back(number);
+                    }
+
+                    double mean = 0;
+                    for (double v : values)
+                        mean += v;
+                    mean /= values.size();
+
+                    double result = mean;
+                    if (std::strcmp(aggregate, "median") == 0) {
+                        std::sort(values.begin(), values.end());
+                        std::size_t middle = values.size() / 2;
+                        result = values.size() % 2
+                                     ? values[middle]
+                                     : (values[middle - 1] + values[middle]) / 2;
+                    } else if (std::strcmp(aggregate, "stddev") == 0) {
+                        double squares = 0;
+                        for (double v : values)
+                            squares += (v - mean) * (v - mean);
+                        result = values.size() > 1 ? std::sqrt(squares / (values.size() - 1)) : 0;
+                    }
+                    fields.emplace_back(key, FormatNumber(result));
+                }
+
+                std::string& name = *FindField(fields, "name");
+                name.insert(name.size() - 1, std::string("_") + aggregate);
+                SetField(fields, "run_type", "\"aggregate\"");
+                SetField(fields, "iterations", std::to_string(t_repetitions.size()));
+                SetField(fields, "aggregate_name", std::string("\"") + aggregate + "\"");
+                SetField(fields, "aggregate_unit", "\"time\"");
+                aggregates.push_back(std::move(fields));
+            }
+            return aggregates;
+        }
+
+        std::string UnquoteName(const std::string& t_value)
+        {
+            std::string name;
+            for (std::size_t i = 1; i + 1 < t_value.size(); ++i) {
+                if (t_value[i] == '\\')
+                    ++i;
+                name += t_value[i];
+            }
+            return name;
+        }
+
+        //! @brief Prints an aggregate to the console, like the console reporter would.
+        void PrintAggregate(RunFields& t_aggregate)
+        {
+            std::string* unit = FindField(t_aggregate, "time_unit");
+            std::string* realTime = FindField(t_aggregate, "real_time");
+            std::string* cpuTime = FindField(t_aggregate, "cpu_time");
+            if (realTime == nullptr || cpuTime == nullptr)
+                return;
+
+            const std::string timeUnit = unit ? UnquoteName(*unit) : "ns";
+            std::printf("%-60s %13.4g %-2s %13.4g %-2s\n",
+                        UnquoteName(*FindField(t_aggregate, "name")).c_str(),
+                        std::strtod(realTime->c_str(), nullptr),
+                        timeUnit.c_str(),
+                        std::strtod(cpuTime->c_str(), nullptr),
+                        timeUnit.c_str());
+            std::fflush(stdout);
+        }
+
+        std::string ReadFile(const std::string& t_path)
+        {
+            std::ifstream file(t_path);
+            std::stringstream contents;
+            contents << file.rdbuf();
+            return contents.str();
+        }
+    }
+
+    IsolationMode GetIsolationMode()
+    {
+        const char* mode = std::getenv(c_isolateEnv);
+        if (mode == nullptr)
+            return IsolationMode::NONE;
+        if (std::strcmp(mode, "family") == 0)
+            return IsolationMode::FAMILY;
+        if (std::strcmp(mode, "run") == 0)
+            return IsolationMode::RUN;
+        if (std::strcmp(mode, "repetition") == 0)
+            return IsolationMode::REPETITION;
+        return IsolationMode::NONE;
+    }
+
+    int RunIsolated(int t_argc, char** t_argv, IsolationMode t_mode)
+    {
+        // Output and filter are owned by the parent, everything else is passed through
+        std::string outPath;
+        std::string outFormat = "json";
+        std::vector<std::string> listArgs;
+        std::vector<std::string> passedArgs;
+        // Repetitions are run by the parent when every repetition gets its own process
+        const bool perRepetition = t_mode == IsolationMode::REPETITION;
+        int repetitions = 1;
+        bool aggregatesOnly = false;
+        for (int i = 1; i < t_argc; ++i) {
+            std::string arg = t_argv[i];
+            if (perRepetition && StartsWith(arg, "--benchmark_repetitions=")) {
+                repetitions = std::max(std::atoi(arg.c_str() + arg.find('=') + 1), 1);
+            } else if (perRepetition && StartsWith(arg, "--benchmark_report_aggregates_only=")) {
+                aggregatesOnly = arg.substr(arg.find('=') + 1) == "true";
+            } else if (StartsWith(arg, "--benchmark_out=")) {
+                outPath = arg.substr(std::strlen("--benchmark_out="));
+            } else if (StartsWith(arg, "--benchmark_out_format=")) {
+                outFormat = arg.substr(std::strlen("--benchmark_out_format="));
+            } else if (StartsWith(arg, "--benchmark_filter=")) {
+                listArgs.push_back(arg);
+            } else {
+                passedArgs.push_back(arg);
+                listArgs.push_back(arg);
+            }
+        }
+
+        if (!outPath.empty() && outFormat != "json") {
+            std::cerr << "Isolated runs can only merge JSON output (--benchmark_out_format=json)"
+                      << std::endl;
+            return 1;
+        }
+
+        // Let the child expand the filter, so that names match exactly what it would run
+        std::string list;
+        listArgs.push_back("--benchmark_list_tests=true");
+        const std::string self = t_argv[0];
+        if (RunChild(self, listArgs, &list) != 0) {
+            std::cerr << "Failed to list benchmarks" << std::endl;
+            return 1;
+        }
+
+        // Group names, keeping the registration order
+        std::vector<std::pair<std::string, std::vector<std::string>>> groups;
+        std::istringstream names(list);
+        std::string name;
+        while (std::getline(names, name)) {
+            if (name.empty())
+                continue;
+
+            std::string key =
+                (t_mode == IsolationMode::FAMILY) ? name.substr(0, name.find('/')) : name;
+            auto group = std::find_if(groups.begin(), groups.end(), [&](const auto& t_group) {
+                return t_group.first == key;
+            });
+            if (group == groups.end()) {
+                groups.push_back({ key, {} });
+                group = std::prev(groups.end());
+            }
+            group->second.push_back(name);
+        }
+
+        int exitCode = 0;
+        std::string context;
+        std::vector<std::string> results;
+        for (auto& [key, groupNames] : groups) {
+            std::string filter = "--benchmark_filter=^(";
+            for (std::size_t i = 0; i < groupNames.size(); ++i)
+                filter += (i ? "|" : "") + EscapeRegex(groupNames[i]);
+            filter += ")$";
+
+            std::vector<std::string> args = passedArgs;
+            args.push_back(filter);
+            if (perRepetition)
+                args.push_back("--benchmark_repetitions=1");
+
+            // Aggregates are computed from the JSON results, even if the parent doesn't write any
+            const bool collectJson = !outPath.empty() || (perRepetition && repetitions > 1);
+            std::vector<RunFields> repetitionRuns;
+            for (int repetition = 0; repetition < (perRepetition ? repetitions : 1); ++repetition) {
+                std::vector<std::string> childArgs = args;
+                char childOutPath[] = "/tmp/mpp-bench-XXXXXX";
+                if (collectJson) {
+                    int fd = mkstemp(childOutPath);
+                    if (fd < 0) {
+                        std::cerr << "Failed to create a temporary file" << std::endl;
+                        return 1;
+                    }
+                    close(fd);
+                    childArgs.push_back(std::string("--benchmark_out=") + childOutPath);
+                    childArgs.push_back("--benchmark_out_format=json");
+                }
+
+                int childExitCode = RunChild(self, childArgs, nullptr);
+                if (childExitCode != 0) {
+                    std::cerr << "Benchmarks of " << key << " failed with exit code "
+                              << childExitCode << std::endl;
+                    exitCode = 1;
+                }
+
+                if (!collectJson)
+                    continue;
+
+                std::string json = ReadFile(childOutPath);
+                std::remove(childOutPath);
+
+                std::string benchmarks = ExtractBenchmarks(json);
+                if (context.empty())
+                    context = json.substr(0, json.find(c_benchmarksKey));
+                if (!perRepetition) {
+                    if (!benchmarks.empty())
+                        results.push_back(std::move(benchmarks));
+                    continue;
+                }
+
+                for (auto& object : SplitObjects(benchmarks)) {
+                    RunFields run = ParseRun(object);
+                    SetField(run, "repetitions", std::to_string(repetitions));
+                    SetField(run, "repetition_index", std::to_string(repetition));
+                    if (!aggregatesOnly)
+                        results.push_back(FormatRun(run));
+                    repetitionRuns.push_back(std::move(run));
+                }
+            }
+
+            for (auto& aggregate : AggregateRepetitions(std::move(repetitionRuns))) {
+                PrintAggregate(aggregate);
+                results.push_back(FormatRun(aggregate));
+            }
+        }
+
+        if (!outPath.empty()) {
+            std::ofstream out(outPath);
+            out << (context.empty() ? "{\n  " : context) << c_benchmarksKey << "\n    ";
+            for (std::size_t i = 0; i < results.size(); ++i)
+                out << (i ? ",\n    " : "") << results[i];
+            out << "\n  ]\n}\n";
+        }
+
+        return exitCode;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+namespace bm::utils {
+    enum class IsolationMode
+    {
+        //! @brief All benchmarks run in the current process (default).
+        NONE = 0,
+        //! @brief One child process per benchmark family (name up to the first '/').
+        FAMILY,
+        //! @brief One child process per benchmark run (all repetitions of it).
+        RUN,
+        /**
+         * @brief One child process per repetition of every benchmark run, each started with
+         * --benchmark_repetitions=1. The parent computes the mean/median/stddev aggregates.
+         */
+        REPETITION
+    };
+
+    /**
+     * @brief Reads the isolation mode from MPP_BENCH_ISOLATE ("family", "run" or "repetition").
+     * Anything else (or unset) means IsolationMode::NONE.
+     */
+    IsolationMode GetIsolationMode();
+
+    /**
+     * @brief Runs the selected benchmarks in freshly exec'ed copies of the current binary, so
+     * that heap state and peak RSS of one benchmark can't leak into the next one. Each child
+     * initializes the allocator itself. Children print to the console as usual, their JSON
+     * results are merged into the --benchmark_out file of the parent (if given).
+     * @param t_argc argc of main(), before benchmark::Initialize()
+     * @param t_argv argv of main(), before benchmark::Initialize()
+     * @param t_mode How to group benchmarks into child processes
+     * @return Process exit code: 0 if every child succeeded
+     */
+    int RunIsolated(int t_argc, char** t_argv, IsolationMode t_mode);
+}
@@ -1,9 +1,116 @@
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
 #include <jemalloc/jemalloc.h>
 
-void BenchmarkAllocatorInitialize()
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+namespace {
+    //! @brief Decay value that leaves jemalloc's default in place
+    constexpr ssize_t c_keepDecay = -2;
+
+    struct JemallocProfile
+    {
+        const char* name;
+        //! @brief Threads are bound round-robin to this many new arenas (0: automatic assignment)
+        unsigned narenas;
+        //! @brief Delay before unused dirty/muzzy pages are purged in ms (-1: never purge)
+        ssize_t dirtyDecayMs;
+        ssize_t muzzyDecayMs;
+        bool tcache;
+    };
+
+    // opt.narenas and opt.tcache_max are read-only once jemalloc is initialized, which happens
+    // before main(). Arenas are created and bound explicitly instead, and the thread cache can
+    // only be switched off.
+    constexpr JemallocProfile c_profiles[] = {
+        { "default", 0, c_keepDecay, c_keepDecay, true },
+        { "single-arena", 1, c_keepDecay, c_keepDecay, true },
+        { "four-arenas", 4, c_keepDecay, c_keepDecay, true },
+        { "no-tcache", 0, c_keepDecay, c_keepDecay, false },
+        { "eager-purge", 0, 0, 0, true },
+        { "no-purge", 0, -1, -1, true },
+    };
+
+    const JemallocProfile* g_profile = &c_profiles[0];
+    //! @brief Index of the first arena created for the profile
+    unsigned g_firstArena = 0;
+    std::atomic<unsigned> g_nextArena{ 0 };
+
+    /**
+     * @brief Sets t_decay ("dirty_decay_ms"/"muzzy_decay_ms") of new arenas (arenas.<decay>) and
+     * of every existing one (arena.<i>.<decay>, MALLCTL_ARENAS_ALL only works for purging).
+     */
+    bool SetDecay(const std::string& t_decay, ssize_t t_ms)
+    {
+        if (t_ms == c_keepDecay)
+            return true;
+
+        std::string newArenas = "arenas." + t_decay;
+        if (mallctl(newArenas.c_str(), nullptr, nullptr, &t_ms, sizeof(t_ms)) != 0)
+            return false;
+
+        unsigned narenas = 0;
+        std::size_t size = sizeof(narenas);
+        if (mallctl("arenas.narenas", &narenas, &size, nullptr, 0) != 0)
+            return false;
+
+        for (unsigned i = 0; i < narenas; ++i) {
+            std::string arena = "arena." + std::to_string(i) + "." + t_decay;
+            // Indices of arenas that were never created fail with EFAULT
+            int result = mallctl(arena.c_str(), nullptr, nullptr, &t_ms, sizeof(t_ms));
+            if (result != 0 && result != EFAULT)
+                return false;
+        }
+        return true;
+    }
+
+    //! @brief Applies the per-thread settings of the profile to the calling thread
+    void ApplyThreadProfile()
+    {
+        if (g_profile->narenas != 0) {
+            unsigned arena = g_firstArena + g_nextArena.fetch_add(1) % g_profile->narenas;
+            mallctl("thread.arena", nullptr, nullptr, &arena, sizeof(arena));
+        }
+
+        if (!g_profile->tcache) {
+            bool enabled = false;
+            mallctl("thread.tcache.enabled", nullptr, nullptr, &enabled, sizeof(enabled));
+        }
+    }
+}
+
+bool BenchmarkAllocatorInitialize(const char* t_profile)
 {
-    return;
+    const JemallocProfile* profile = bm::profiles::Find(c_profiles, t_profile);
+    if (profile == nullptr)
+        return false;
+    g_profile = profile;
+
+    // Before the arenas are created, so that they pick up the new defaults
+    if (!SetDecay("dirty_decay_ms", profile->dirtyDecayMs) ||
+        !SetDecay("muzzy_decay_ms", profile->muzzyDecayMs))
+        return false;
+
+    for (unsigned i = 0; i < profile->narenas; ++i) {
+        unsigned arena = 0;
+        std::size_t size = sizeof(arena);
+        if (mallctl("arenas.create", &arena, &size, nullptr, 0) != 0)
+            return false;
+        if (i == 0)
+            g_firstArena = arena;
+    }
+
+    ApplyThreadProfile();
+    return true;
+}
+
+const char* const* BenchmarkAllocatorProfiles()
+{
+    return bm::profiles::Names(c_profiles);
 }
 
 void BenchmarkAllocatorFinalize()
@@ -20,3 +127,67 @@ void BenchmarkDeallocate(void* t_ptr)
 {
     free(t_ptr);
 }
+
+void BenchmarkThreadInitialize()
+{
+    ApplyThreadProfile();
+}
+
+void BenchmarkThreadFinalize()
+{
+    return;
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    return kBenchmarkCapThreadSafe | kBenchmarkCapNativeReallocate |
+           kBenchmarkCapNativeAllocateZeroed | kBenchmarkCapNativeDeallocateSized |
+           kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return realloc(t_ptr, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    return mallocx(t_size, MALLOCX_ALIGN(t_alignment));
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return calloc(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    sdallocx(t_ptr, t_size, 0);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    return sallocx(t_ptr, 0);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+    // Statistics are cached by jemalloc, bump the epoch to refresh them
+    uint64_t epoch = 1;
+    std::size_t size = sizeof(epoch);
+    if (mallctl("epoch", &epoch, &size, &epoch, size) != 0)
+        return false;
+
+    size = sizeof(std::size_t);
+    if (mallctl("stats.active", &t_stats.activeBytes, &size, nullptr, 0) != 0 ||
+        mallctl("stats.mapped", &t_stats.mappedBytes, &size, nullptr, 0) != 0)
+        return false;
+
+    return true;
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    std::string purge = "arena." + std::to_string(MALLCTL_ARENAS_ALL) + ".purge";
+    return mallctl(purge.c_str(), nullptr, nullptr, nullptr, 0) == 0;
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace bm::utils {
+    //! @brief Reads a cheap monotonic timestamp (TSC on x86, nanoseconds elsewhere).
+    inline uint64_t ReadTimestamp()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    //! @brief Returns how many ReadTimestamp() ticks happen in one nanosecond (calibrated once).
+    inline double GetTimestampTicksPerNs()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        static const double s_ticksPerNs = []() {
+            constexpr auto c_calibrationTime = std::chrono::milliseconds(20);
+            auto clockStart = std::chrono::steady_clock::now();
+            uint64_t tscStart = ReadTimestamp();
+            while (std::chrono::steady_clock::now() - clockStart < c_calibrationTime) {
+            }
+            uint64_t tscEnd = ReadTimestamp();
+            auto clockEnd = std::chrono::steady_clock::now();
+            auto elapsedNs =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(clockEnd - clockStart).count();
+            return static_cast<double>(tscEnd - tscStart) / static_cast<double>(elapsedNs);
+        }();
+        return s_ticksPerNs;
+#else
+        return 1.0;
+#endif
+    }
+
+    /**
+     * @brief HDR-style histogram of latencies (in ReadTimestamp() ticks). Values are split into
+     * power-of-two ranges, each divided into c_subBuckets linear buckets, so the relative error
+     * is below 1 / c_subBuckets for any value. Storage is a fixed array, so Record() never
+     * allocates.
+     */
+    class LatencyHistogram
+    {
+    public:
+        //! @brief Records a single value.
+        inline void Record(uint64_t t_ticks)
+        {
+            ++m_buckets[GetBucketIdx(t_ticks)];
+            ++m_totalCount;
+            if (t_ticks > m_max)
+                m_max = t_ticks;
+            if (t_ticks < m_min)
+                m_min = t_ticks;
+        }
+
+        //! @brief Adds all values recorded by t_other.
+        void Merge(const LatencyHistogram& t_other)
+        {
+            for (std::size_t i = 0; i < m_buckets.size(); ++i)
+                m_buckets[i] += t_other.m_buckets[i];
+            m_totalCount += t_other.m_totalCount;
+            if (t_other.m_max > m_max)
+                m_max = t_other.m_max;
+            if (t_other.m_min < m_min)
+                m_min = t_other.m_min;
+        }
+
+        //! @brief Returns the value (in ticks) below which t_percentile percent of values fall.
+        uint64_t GetPercentile(double t_percentile) const
+        {
+            if (m_totalCount == 0)
+                return 0;
+
+            uint64_t target = static_cast<uint64_t>(t_percentile / 100.0 * m_totalCount);
+            if (target == 0)
+                target = 1;
+
+            uint64_t seen = 0;
+            for (std::size_t i = 0; i < m_buckets.size(); ++i) {
+                seen += m_buckets[i];
+                if (seen >= target)
+                    return std::min(GetBucketMidpoint(i), m_max);
+            }
+
+            return m_max;
+        }
+
+        uint64_t GetMin() const
+        {
+            return m_totalCount ? m_min : 0;
+        }
+
+        uint64_t GetMax() const
+        {
+            return m_max;
+        }
+
+        uint64_t GetTotalCount() const
+        {
+            return m_totalCount;
+        }
+
+        /**
+         * @brief Exports min/p50/p90/p99/p99.9/max (converted to nanoseconds) as benchmark counters.
+         * @param t_prefix Counter names prefix, e.g. "AllocLatency"
+         */
+        void ExportCounters(benchmark::State& t_state, const std::string& t_prefix) const
+        {
+            const double ticksPerNs = GetTimestampTicksPerNs();
+            t_state.counters[t_prefix + "MinNs"] = GetMin() / ticksPerNs;
+            t_state.counters[t_prefix + "P50Ns"] = GetPercentile(50.0) / ticksPerNs;
+            t_state.counters[t_prefix + "P90Ns"] = GetPercentile(90.0) / ticksPerNs;
+            t_state.counters[t_prefix + "P99Ns"] = GetPercentile(99.0) / ticksPerNs;
+            t_state.counters[t_prefix + "P999Ns"] = GetPercentile(99.9) / ticksPerNs;
+            t_state.counters[t_prefix + "MaxNs"] = GetMax() / ticksPerNs;
+        }
+
+    private:
+        static constexpr uint32_t c_subBucketBits = 5;
+        static constexpr uint32_t c_subBuckets = 1 << c_subBucketBits;
+        static constexpr uint32_t c_totalBuckets = (64 - c_subBucketBits + 1) * c_subBuckets;
+
+        static inline uint32_t GetBucketIdx(uint64_t t_value)
+        {
+            if (t_value < c_subBuckets)
+                return t_value;
+
+            uint32_t shift = (63 - __builtin_clzll(t_value)) - c_subBucketBits;
+            return (shift + 1) * c_subBuckets + ((t_value >> shift) - c_subBuckets);
+        }
+
+        static uint64_t GetBucketMidpoint(uint32_t t_idx)
+        {
+            if (t_idx < c_subBuckets)
+                return t_idx;
+
+            uint32_t shift = t_idx / c_subBuckets - 1;
+            uint64_t lowest = static_cast<uint64_t>(t_idx % c_subBuckets + c_subBuckets) << shift;
+            return lowest + ((uint64_t(1) << shift) >> 1);
+        }
+
+        std::array<uint32_t, c_totalBuckets> m_buckets{};
+        uint64_t m_totalCount = 0;
+        uint64_t m_max = 0;
+        uint64_t m_min = std::numeric_limits<uint64_t>::max();
+    };
+
+    /**
+     * @brief BenchmarkAllocate() that records its latency into t_histogram, when the build is
+     * configured with MPP_BENCH_LATENCY_HISTOGRAMS=ON. Otherwise it is a plain BenchmarkAllocate().
+     */
+    inline void* InstrumentedAllocate(LatencyHistogram& t_histogram, std::size_t t_size)
+    {
+#ifdef MPP_BENCH_LATENCY_HISTOGRAMS
+        uint64_t start = ReadTimestamp();
+        void* ptr = BenchmarkAllocate(t_size);
+        t_histogram.Record(ReadTimestamp() - start);
+        return ptr;
+#else
+        return BenchmarkAllocate(t_size);
+#endif
+    }
+
+    //! @brief BenchmarkDeallocate() counterpart of InstrumentedAllocate().
+    inline void InstrumentedDeallocate(LatencyHistogram& t_histogram, void* t_ptr)
+    {
+#ifdef MPP_BENCH_LATENCY_HISTOGRAMS
+        uint64_t start = ReadTimestamp();
+        BenchmarkDeallocate(t_ptr);
+        t_histogram.Record(ReadTimestamp() - start);
+#else
+        BenchmarkDeallocate(t_ptr);
+#endif
+    }
+
+    //! @brief BenchmarkDeallocateSized() counterpart of InstrumentedAllocate().
+    inline void InstrumentedDeallocateSized(LatencyHistogram& t_histogram,
+                                            void* t_ptr,
+                                            std::size_t t_size)
+    {
+#ifdef MPP_BENCH_LATENCY_HISTOGRAMS
+        uint64_t start = ReadTimestamp();
+        BenchmarkDeallocateSized(t_ptr, t_size);
+        t_histogram.Record(ReadTimestamp() - start);
+#else
+        BenchmarkDeallocateSized(t_ptr, t_size);
+#endif
+    }
+
+    //! @brief Exports t_histogram counters if latency instrumentation is compiled in.
+    inline void ExportInstrumentedLatency(benchmark::State& t_state,
+                                          const LatencyHistogram& t_histogram,
+                                          const std::string& t_prefix)
+    {
+#ifdef MPP_BENCH_LATENCY_HISTOGRAMS
+        t_histogram.ExportCounters(t_state, t_prefix);
+#endif
+    }
+}
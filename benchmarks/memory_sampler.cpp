@@ -0,0 +1,96 @@
+#include "memory_sampler.h"
+#include "benchmark_utils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+namespace bm::utils {
+    MemorySampler::MemorySampler(std::string t_name)
+        : m_name(std::move(t_name))
+        , m_interval(1000)
+    {
+        if (const char* interval = std::getenv("MPP_BENCH_RSS_SAMPLE_INTERVAL_US")) {
+            m_interval = std::chrono::microseconds(std::max(1L, std::atol(interval)));
+        }
+
+        // Reserve upfront, so that the sampler thread doesn't allocate while benchmark runs
+        m_samples.reserve(c_maxStoredSamples);
+    }
+
+    MemorySampler::~MemorySampler()
+    {
+        if (m_thread.joinable())
+            Stop();
+    }
+
+    void MemorySampler::Start()
+    {
+        m_stopRequested = false;
+        m_startTime = std::chrono::steady_clock::now();
+        TakeSample();
+        m_thread = std::thread(&MemorySampler::SamplerLoop, this);
+    }
+
+    void MemorySampler::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopRequested = true;
+        }
+        m_stopCv.notify_one();
+        m_thread.join();
+
+        TakeSample();
+        m_finalRss = m_samples.empty() ? GetProcCurrentMemoryUsage() : m_samples.back().rss;
+    }
+
+    void MemorySampler::TakeSample()
+    {
+        std::size_t rss = GetProcCurrentMemoryUsage();
+        auto time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_startTime);
+
+        if (m_samples.size() < c_maxStoredSamples)
+            m_samples.push_back(Sample{ time, rss });
+        if (rss > m_peakRss)
+            m_peakRss = rss;
+        m_rssSum += rss;
+        ++m_totalSamples;
+    }
+
+    void MemorySampler::SamplerLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopCv.wait_for(lock, m_interval, [this]() { return m_stopRequested; })) {
+            TakeSample();
+        }
+    }
+
+    void MemorySampler::Export(benchmark::State& t_state) const
+    {
+        t_state.counters["RssPeak"] = GetPeakRss();
+        t_state.counters["RssMean"] = GetMeanRss();
+        t_state.counters["RssFinal"] = GetFinalRss();
+
+        const char* timelinePath = std::getenv("MPP_BENCH_RSS_TIMELINE");
+        if (timelinePath == nullptr)
+            return;
+
+        std::ofstream timeline(timelinePath, std::ios::app);
+        if (timeline.tellp() == 0)
+            timeline << "benchmark,time_us,rss_bytes\n";
+
+        // Benchmark names contain quotes (BM_Complex), escape them for CSV
+        std::string name = "\"";
+        for (char c : m_name) {
+            name += c;
+            if (c == '"')
+                name += '"';
+        }
+        name += '"';
+
+        for (auto& sample : m_samples)
+            timeline << name << ',' << sample.time.count() << ',' << sample.rss << '\n';
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "benchmark/benchmark.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bm::utils {
+    /**
+     * @brief Samples the process RSS (/proc/self/statm) from a background thread while a
+     * benchmark runs. Unlike ru_maxrss it also shows memory being returned to the OS, and it isn't
+     * inherited from previously executed benchmarks.
+     *
+     * The sampling interval is taken from MPP_BENCH_RSS_SAMPLE_INTERVAL_US (default 1000 us). If
+     * MPP_BENCH_RSS_TIMELINE is set, every sample is appended to that CSV file as
+     * "benchmark,time_us,rss_bytes".
+     */
+    class MemorySampler
+    {
+    public:
+        struct Sample
+        {
+            //! @brief Time since Start()
+            std::chrono::microseconds time;
+            std::size_t rss;
+        };
+
+        /**
+         * @brief Construct a new MemorySampler object
+         * @param t_name Benchmark name to tag the time series with
+         */
+        explicit MemorySampler(std::string t_name);
+        MemorySampler(const MemorySampler&) = delete;
+        MemorySampler& operator=(const MemorySampler&) = delete;
+        ~MemorySampler();
+
+        //! @brief Starts the sampler thread.
+        void Start();
+
+        //! @brief Stops the sampler thread and takes the final sample.
+        void Stop();
+
+        std::size_t GetPeakRss() const
+        {
+            return m_peakRss;
+        }
+
+        std::size_t GetMeanRss() const
+        {
+            return m_totalSamples ? static_cast<std::size_t>(m_rssSum / m_totalSamples) : 0;
+        }
+
+        //! @brief RSS right after Stop(), i.e. after the benchmark cleaned up.
+        std::size_t GetFinalRss() const
+        {
+            return m_finalRss;
+        }
+
+        const std::vector<Sample>& GetSamples() const
+        {
+            return m_samples;
+        }
+
+        /**
+         * @brief Exports RssPeak/RssMean/RssFinal counters and appends the time series to the
+         * MPP_BENCH_RSS_TIMELINE file (if configured).
+         */
+        void Export(benchmark::State& t_state) const;
+
+    private:
+        //! @brief Upper bound of stored samples. Peak/mean are still updated beyond it.
+        static constexpr std::size_t c_maxStoredSamples = 1 << 16;
+
+        std::string m_name;
+        std::chrono::microseconds m_interval;
+        std::chrono::steady_clock::time_point m_startTime;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_stopCv;
+        bool m_stopRequested = false;
+
+        std::vector<Sample> m_samples;
+        std::size_t m_peakRss = 0;
+        std::size_t m_finalRss = 0;
+        uint64_t m_totalSamples = 0;
+        long double m_rssSum = 0;
+
+        void TakeSample();
+        void SamplerLoop();
+    };
+}
@@ -1,11 +1,23 @@
+#include "allocator_api_fallback.h"
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
+#include "mpplib/chunk.hpp"
 #include "mpplib/memory_manager.hpp"
 #include "mpplib/mpp.hpp"
 #include <memory>
 
-void BenchmarkAllocatorInitialize()
+bool BenchmarkAllocatorInitialize(const char* t_profile)
 {
+    if (!bm::profiles::IsDefault(t_profile))
+        return false;
+
     mpp::g_memoryManager = std::make_unique<mpp::MemoryManager>();
+    return true;
+}
+
+const char* const* BenchmarkAllocatorProfiles()
+{
+    return bm::profiles::DefaultOnly();
 }
 
 void BenchmarkAllocatorFinalize()
@@ -22,3 +34,60 @@ void BenchmarkDeallocate(void* t_ptr)
 {
     mpp::Deallocate(t_ptr);
 }
+
+void BenchmarkThreadInitialize()
+{
+    return;
+}
+
+void BenchmarkThreadFinalize()
+{
+    return;
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    // The global mpp::g_memoryManager (and its GC) is not synchronized. There are no
+    // realloc/calloc/aligned/sized entry points, everything but aligned allocations falls back.
+    return 0;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return bm::fallback::Reallocate(t_ptr, t_oldSize, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    return nullptr;
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return bm::fallback::AllocateZeroed(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    bm::fallback::DeallocateSized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    // Chunk size includes the chunk header in front of the user data
+    mpp::Chunk* chunk = mpp::Chunk::GetHeaderPtr(t_ptr);
+    return chunk->GetSize() - (static_cast<char*>(t_ptr) - reinterpret_cast<char*>(chunk));
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+    // Arena statistics are only collected with MPP_STATS, which is disabled for benchmarking
+    return false;
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    // There is no explicit purge, a collection (which compacts the GC heap) is the closest thing
+    mpp::CollectGarbage();
+    return true;
+}
@@ -1,20 +1,30 @@
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
 #include "benchmark/benchmark.h"
 #include "benchmark_constants.h"
 #include "benchmark_utils.h"
+#include "latency_histogram.h"
+#include "memory_sampler.h"
 #include "memplusplus/libmemplusplus/include/mpplib/memory_manager.hpp"
+#include "mpplib/chunk.hpp"
 #include "mpplib/memory_manager.hpp"
 #include "mpplib/mpp.hpp"
 #include "mpplib/utils/macros.hpp"
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <unordered_set>
+#include <vector>
 
 class WorkerGC
 {
@@ -107,20 +117,37 @@ public:
         }
     };
 
+    /**
+     * @brief Heap shared by the mutators of a multi-threaded run. memplusplus is not thread-safe
+     * (every SharedGcPtr copy updates the GC's pointer set), so mutators serialize every graph
+     * operation on the heap lock, and a collection stops all of them.
+     */
+    struct SharedHeap
+    {
+        std::mutex lock;
+        //! @brief Cross-cluster region, reachable from (and pointing into) every mutator subgraph
+        std::vector<mpp::SharedGcPtr<Vertex>> crossClusterVertices;
+    };
+
     /**
      * @brief Construct a new WorkerGC object
      * @param t_bmState The benchmark state
      * @param t_totalOps The total number of loop iterations to perform
      * @param t_transitionMatrix The transition matrix
      * @param t_xorshiftSeed The seed for the xorshift random number generator
+     * @param t_totalVertices Number of vertex slots in the subgraph of this worker
+     * @param t_sharedHeap Shared heap of a multi-threaded run (nullptr if single-threaded)
      */
     WorkerGC(benchmark::State& t_bmState,
              uint32_t t_totalOps = 1024 * 128,
              std::array<std::array<float, 7>, 7> t_transitionMatrix = c_defaultTransitionMatrix,
-             uint64_t t_xorshiftSeed = 0x133796A5FF21B3C7)
+             uint64_t t_xorshiftSeed = g_gcXorshiftSeed,
+             uint32_t t_totalVertices = 1024,
+             SharedHeap* t_sharedHeap = nullptr)
         : m_bmState(t_bmState)
-        , m_activePtrs(1024, nullptr)
+        , m_activePtrs(t_totalVertices, nullptr)
         , m_totalOps(t_totalOps)
+        , m_sharedHeap(t_sharedHeap)
         , m_transitionMatrix(t_transitionMatrix)
     {
         m_transitionsRngState = bm::utils::XorshiftNext(t_xorshiftSeed);
@@ -128,8 +155,24 @@ public:
 
         CheckTransitionMatrix();
         CreateRandomGraph();
+
+        if (m_sharedHeap == nullptr)
+            m_liveBytes = SumReachableChunkBytes();
+        m_bytesAllocatedSinceGc = 0;
     }
 
+    //! @brief A single CollectGarbage() call.
+    struct GcRecord
+    {
+        double pauseNs;
+        //! @brief Bytes of vertex chunks on the heap before the collection (live and garbage).
+        std::size_t heapBytesBefore;
+        //! @brief Bytes of vertex chunks reachable from the roots after the collection.
+        std::size_t liveBytesAfter;
+        std::size_t gcPtrsBefore;
+        std::size_t gcPtrsAfter;
+    };
+
     struct BenchResults
     {
         //! @brief Total iterations count.
@@ -140,6 +183,12 @@ public:
 
         //! @brief Number of active GC-Ptrs before benchmark exits.
         uint32_t totalActiveGcPtrs;
+
+        //! @brief Time spent inside CollectGarbage() (ns).
+        double gcTimeNs;
+
+        //! @brief Time spent waiting for the shared heap lock (ns), 0 if single-threaded.
+        double lockWaitNs;
     };
 
     /**
@@ -151,76 +200,63 @@ public:
     {
         while (m_ops <= m_totalOps) {
             ++m_ops;
-            switch (GetNextOperation()) {
-                case Operation::CREATE_VERTEX: {
-                    MPP_LOG_DBG("CREATE_VERTEX");
-                    CreateVertexIfDoesntExist();
-                    break;
-                }
-                case Operation::REMOVE_VERTEX: {
-                    MPP_LOG_DBG("REMOVE_VERTEX");
-                    m_activePtrs.at(GetActivePtrsRandIdx()).Reset();
-                    break;
-                }
-                case Operation::CREATE_EDGE: {
-                    MPP_LOG_DBG("CREATE_EDGE");
-                    auto vtx_to_add = GetRandomActivePtr();
-                    auto vtx_add_to = GetRandomActivePtr();
-
-                    if (!vtx_to_add.has_value() || !vtx_add_to.has_value()) {
-                        continue;
-                    }
+            Operation op = GetNextOperation();
+            if (m_sharedHeap == nullptr) {
+                PerformOperation(op);
+                continue;
+            }
 
-                    vtx_add_to.value().get()->AddPointer(vtx_to_add.value().get());
+            uint64_t waitStart = bm::utils::ReadTimestamp();
+            std::lock_guard<std::mutex> lock(m_sharedHeap->lock);
+            m_lockWaitTicks += bm::utils::ReadTimestamp() - waitStart;
+            PerformOperation(op);
+        }
 
-                    break;
-                }
-                case Operation::REMOVE_EDGE: {
-                    MPP_LOG_DBG("REMOVE_EDGE");
-                    auto vertex = GetRandomActivePtr();
-                    if (!vertex.has_value()) {
-                        continue;
-                    }
+        std::unique_lock<std::mutex> lock;
+        if (m_sharedHeap != nullptr)
+            lock = std::unique_lock<std::mutex>(m_sharedHeap->lock);
+
+        const double ticksPerNs = bm::utils::GetTimestampTicksPerNs();
+        return BenchResults{
+            m_ops,
+            static_cast<uint32_t>(m_totalGcInvocations),
+            static_cast<uint32_t>(mpp::g_memoryManager->GetGC().GetGcPtrs().size()),
+            m_gcTicks / ticksPerNs,
+            m_lockWaitTicks / ticksPerNs
+        };
+    }
 
-                    vertex.value().get()->RemovePointer();
-                    break;
-                }
-                case Operation::WRITE_DATA: {
-                    MPP_LOG_DBG("WRITE_DATA");
-                    auto vertex = GetRandomActivePtr();
-                    if (!vertex.has_value()) {
-                        continue;
-                    }
+    //! @brief Durations of all CollectGarbage() calls (ticks).
+    const bm::utils::LatencyHistogram& GetGcPauses() const
+    {
+        return m_gcPauses;
+    }
 
-                    vertex.value().get()->GetData() =
-                        bm::utils::XorshiftNext(m_defaultRngState, (uint64_t)0, 0xdeadbeef);
-                    break;
-                }
-                case Operation::READ_DATA: {
-                    MPP_LOG_DBG("READ_DATA");
-                    auto vertex = GetRandomActivePtr();
-                    if (!vertex.has_value()) {
-                        continue;
-                    }
+    /**
+     * @brief Per-collection heap sizes. Only recorded single-threaded, since the roots of other
+     * mutators aren't known to this worker.
+     */
+    const std::vector<GcRecord>& GetGcRecords() const
+    {
+        return m_gcRecords;
+    }
 
-                    volatile auto data = vertex.value().get()->GetData();
-                    break;
-                }
-                case Operation::COLLECT_GARBAGE: {
-                    MPP_LOG_DBG("COLLECT_GARBAGE");
-                    m_totalGcInvocations++;
-                    mpp::CollectGarbage();
-                    break;
-                }
-                default:
-                    break;
-            }
-        }
+    //! @brief Time spent computing GcRecord heap sizes, to be excluded from the measured time.
+    double GetInstrumentationTimeNs() const
+    {
+        return m_instrumentationTicks / bm::utils::GetTimestampTicksPerNs();
+    }
 
-        return BenchResults{ m_ops,
-                             static_cast<uint32_t>(m_totalGcInvocations),
-                             static_cast<uint32_t>(
-                                 mpp::g_memoryManager->GetGC().GetGcPtrs().size()) };
+    /**
+     * @brief Fills the shared cross-cluster region. Must be called before any worker runs.
+     * @param t_sharedHeap Heap to fill
+     * @param t_totalVertices Number of vertices in the region
+     */
+    static void CreateCrossClusterRegion(SharedHeap& t_sharedHeap, uint32_t t_totalVertices)
+    {
+        t_sharedHeap.crossClusterVertices.reserve(t_totalVertices);
+        for (uint32_t i = 0; i < t_totalVertices; ++i)
+            t_sharedHeap.crossClusterVertices.push_back(mpp::MakeShared<Vertex>());
     }
 
 private:
@@ -236,6 +272,30 @@ private:
     //! @brief Total number of GC invocations
     uint64_t m_totalGcInvocations = 0;
 
+    //! @brief Ticks spent inside CollectGarbage()
+    uint64_t m_gcTicks = 0;
+
+    //! @brief Durations of all CollectGarbage() calls
+    bm::utils::LatencyHistogram m_gcPauses;
+
+    //! @brief Heap sizes around every CollectGarbage() call (single-threaded only)
+    std::vector<GcRecord> m_gcRecords;
+
+    //! @brief Chunk bytes of vertices reachable from the roots after the last collection
+    std::size_t m_liveBytes = 0;
+
+    //! @brief Chunk bytes of vertices allocated since the last collection
+    std::size_t m_bytesAllocatedSinceGc = 0;
+
+    //! @brief Ticks spent computing GcRecord heap sizes
+    uint64_t m_instrumentationTicks = 0;
+
+    //! @brief Ticks spent waiting for the shared heap lock
+    uint64_t m_lockWaitTicks = 0;
+
+    //! @brief Shared heap of a multi-threaded run (nullptr if single-threaded)
+    SharedHeap* m_sharedHeap;
+
     //! @brief Random number generator state for transitions
     uint64_t m_transitionsRngState;
 
@@ -251,6 +311,161 @@ private:
     //! @brief Transition matrix with probabilities of switching to another state
     std::array<std::array<float, 7>, 7> m_transitionMatrix;
 
+    //! @brief Performs a single graph operation
+    void PerformOperation(Operation t_op)
+    {
+        switch (t_op) {
+            case Operation::CREATE_VERTEX: {
+                MPP_LOG_DBG("CREATE_VERTEX");
+                CreateVertexIfDoesntExist();
+                break;
+            }
+            case Operation::REMOVE_VERTEX: {
+                MPP_LOG_DBG("REMOVE_VERTEX");
+                m_activePtrs.at(GetActivePtrsRandIdx()).Reset();
+                break;
+            }
+            case Operation::CREATE_EDGE: {
+                MPP_LOG_DBG("CREATE_EDGE");
+                if (m_sharedHeap != nullptr &&
+                    bm::utils::XorshiftNext(m_defaultRngState, 0.0f, 1.0f) <
+                        g_gcCrossClusterEdgeRatio) {
+                    CreateCrossClusterEdge();
+                    break;
+                }
+
+                auto vtx_to_add = GetRandomActivePtr();
+                auto vtx_add_to = GetRandomActivePtr();
+
+                if (!vtx_to_add.has_value() || !vtx_add_to.has_value()) {
+                    return;
+                }
+
+                vtx_add_to.value().get()->AddPointer(vtx_to_add.value().get());
+
+                break;
+            }
+            case Operation::REMOVE_EDGE: {
+                MPP_LOG_DBG("REMOVE_EDGE");
+                auto vertex = GetRandomActivePtr();
+                if (!vertex.has_value()) {
+                    return;
+                }
+
+                vertex.value().get()->RemovePointer();
+                break;
+            }
+            case Operation::WRITE_DATA: {
+                MPP_LOG_DBG("WRITE_DATA");
+                auto vertex = GetRandomActivePtr();
+                if (!vertex.has_value()) {
+                    return;
+                }
+
+                vertex.value().get()->GetData() =
+                    bm::utils::XorshiftNext(m_defaultRngState, (uint64_t)0, 0xdeadbeef);
+                break;
+            }
+            case Operation::READ_DATA: {
+                MPP_LOG_DBG("READ_DATA");
+                auto vertex = GetRandomActivePtr();
+                if (!vertex.has_value()) {
+                    return;
+                }
+
+                volatile auto data = vertex.value().get()->GetData();
+                break;
+            }
+            case Operation::COLLECT_GARBAGE: {
+                MPP_LOG_DBG("COLLECT_GARBAGE");
+                m_totalGcInvocations++;
+                std::size_t gcPtrsBefore = mpp::g_memoryManager->GetGC().GetGcPtrs().size();
+                uint64_t gcStart = bm::utils::ReadTimestamp();
+                mpp::CollectGarbage();
+                uint64_t gcTicks = bm::utils::ReadTimestamp() - gcStart;
+                m_gcTicks += gcTicks;
+                m_gcPauses.Record(gcTicks);
+                RecordCollection(gcTicks, gcPtrsBefore);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    /**
+     * @brief Appends a GcRecord for the collection that just finished. The collector is precise,
+     * so the heap before it held everything alive after the previous one plus everything
+     * allocated since, and after it exactly what is reachable from the roots. Sizes are taken
+     * from the chunk headers, so they include memplusplus' headers and alignment.
+     */
+    void RecordCollection(uint64_t t_pauseTicks, std::size_t t_gcPtrsBefore)
+    {
+        if (m_sharedHeap != nullptr)
+            return;
+
+        uint64_t start = bm::utils::ReadTimestamp();
+        std::size_t heapBytesBefore = m_liveBytes + m_bytesAllocatedSinceGc;
+        m_liveBytes = SumReachableChunkBytes();
+        m_bytesAllocatedSinceGc = 0;
+        m_gcRecords.push_back(GcRecord{ t_pauseTicks / bm::utils::GetTimestampTicksPerNs(),
+                                        heapBytesBefore,
+                                        m_liveBytes,
+                                        t_gcPtrsBefore,
+                                        mpp::g_memoryManager->GetGC().GetGcPtrs().size() });
+        m_instrumentationTicks += bm::utils::ReadTimestamp() - start;
+    }
+
+    //! @brief Size of the chunk t_vertex lives in, as recorded in its memplusplus chunk header
+    static std::size_t GetChunkBytes(const Vertex* t_vertex)
+    {
+        return mpp::Chunk::GetHeaderPtr(const_cast<Vertex*>(t_vertex))->GetSize();
+    }
+
+    //! @brief Sums the chunk sizes of the distinct vertices reachable from m_activePtrs.
+    std::size_t SumReachableChunkBytes() const
+    {
+        std::unordered_set<const Vertex*> visited;
+        std::vector<Vertex*> stack;
+        for (auto& root : m_activePtrs) {
+            if (root != nullptr && visited.insert(root.Get()).second)
+                stack.push_back(root.Get());
+        }
+
+        while (!stack.empty()) {
+            Vertex* vertex = stack.back();
+            stack.pop_back();
+            for (auto& ptr : vertex->GetPointers()) {
+                if (ptr != nullptr && visited.insert(ptr.Get()).second)
+                    stack.push_back(ptr.Get());
+            }
+        }
+
+        std::size_t bytes = 0;
+        for (const Vertex* vertex : visited)
+            bytes += GetChunkBytes(vertex);
+        return bytes;
+    }
+
+    //! @brief Links a random own vertex with a random vertex of the shared region (either way)
+    void CreateCrossClusterEdge()
+    {
+        auto& shared = m_sharedHeap->crossClusterVertices;
+        if (shared.empty())
+            return;
+
+        auto& sharedVertex =
+            shared[bm::utils::XorshiftNext(m_defaultRngState, 0, shared.size() - 1)];
+        auto ownVertex = GetRandomActivePtr();
+        if (!sharedVertex || !ownVertex.has_value())
+            return;
+
+        if (bm::utils::XorshiftNext(m_defaultRngState, 0.0f, 1.0f) < 0.5f)
+            sharedVertex->AddPointer(ownVertex.value().get());
+        else
+            ownVertex.value().get()->AddPointer(sharedVertex);
+    }
+
     mpp::SharedGcPtr<Vertex>& CreateVertexAtIdxIfDoesntExist(uint32_t i)
     {
         if (m_activePtrs.at(i) == nullptr) {
@@ -263,6 +478,7 @@ private:
     mpp::SharedGcPtr<Vertex>& CreateVertexAtIdx(uint32_t i)
     {
         auto vtx = mpp::MakeShared<Vertex>();
+        m_bytesAllocatedSinceGc += GetChunkBytes(vtx.Get());
         m_activePtrs[i] = std::move(vtx);
         return m_activePtrs[i];
     }
@@ -354,6 +570,7 @@ private:
             for (uint32_t i = clusterStart; i < clusterEnd; i++) {
                 if (bm::utils::XorshiftNext(m_defaultRngState, 0.0f, 1.0f) > t_graphDensity) {
                     m_activePtrs[i] = std::move(mpp::MakeShared<Vertex>());
+                    m_bytesAllocatedSinceGc += GetChunkBytes(m_activePtrs[i].Get());
                     auto& vertexAdjList = m_activePtrs[i]->GetPointers();
 
                     for (uint32_t j = 0; j < vertexAdjList.size(); j++) {
@@ -374,9 +591,41 @@ private:
     }
 };
 
+/**
+ * @brief Appends per-collection records to the MPP_BENCH_GC_LOG CSV file (if configured) as
+ * "benchmark,iteration,collection,pause_ns,heap_bytes_before,live_bytes_after,reclaimed_bytes,
+ * gc_ptrs_before,gc_ptrs_after".
+ */
+static void AppendGcLog(const std::string& t_name,
+                        uint64_t t_iteration,
+                        const std::vector<WorkerGC::GcRecord>& t_records)
+{
+    const char* path = std::getenv("MPP_BENCH_GC_LOG");
+    if (path == nullptr)
+        return;
+
+    std::ofstream log(path, std::ios::app);
+    if (log.tellp() == 0) {
+        log << "benchmark,iteration,collection,pause_ns,heap_bytes_before,live_bytes_after,"
+               "reclaimed_bytes,gc_ptrs_before,gc_ptrs_after\n";
+    }
+
+    for (std::size_t i = 0; i < t_records.size(); ++i) {
+        const auto& record = t_records[i];
+        log << t_name << ',' << t_iteration << ',' << i << ',' << record.pauseNs << ','
+            << record.heapBytesBefore << ',' << record.liveBytesAfter << ','
+            << record.heapBytesBefore - record.liveBytesAfter << ',' << record.gcPtrsBefore
+            << ',' << record.gcPtrsAfter << '\n';
+    }
+}
+
 /**
  * @brief Benchmarks the performance of the allocator by performing random (but similar to real
- * program) sequences of operations.
+ * program) sequences of operations. Every CollectGarbage() call is timed (GcPause* counters) and
+ * the vertex chunks on the heap are measured around it (GcHeapBytesBefore/GcLiveBytesAfter/
+ * GcReclaimedBytes, means per collection, sizes from the chunk headers). Heap measurement time is
+ * excluded from the iteration time. Collection phases aren't broken down here: the memplusplus
+ * profiler (MPP_BENCH_GC_PROFILE) writes them to its own trace.
  */
 template<class... Args>
 static void BM_ComplexGc(benchmark::State& state, Args&&... args)
@@ -384,22 +633,128 @@ static void BM_ComplexGc(benchmark::State& state, Args&&... args)
     auto argsTuple = std::make_tuple(std::move(args)...);
     auto totalOps = std::get<0>(argsTuple);
     auto transitionMatrix = std::get<1>(argsTuple);
+    const std::string name = "BM_ComplexGc/" + std::to_string(totalOps);
 
     WorkerGC::BenchResults result;
+    bm::utils::LatencyHistogram gcPauses;
+    std::size_t totalCollections = 0;
+    double heapBytesBefore = 0;
+    double liveBytesAfter = 0;
+    uint64_t iteration = 0;
+
+    bm::utils::MemorySampler memorySampler(name);
+    memorySampler.Start();
     for (auto _ : state) {
-        BenchmarkAllocatorInitialize();
+        BenchmarkAllocatorInitialize(bm::profiles::GetSelectedProfile());
         WorkerGC workergc(state, totalOps, transitionMatrix);
         auto start = std::chrono::high_resolution_clock::now();
         result = workergc.RunBenchmark();
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
-        state.SetIterationTime(duration.count());
+        state.SetIterationTime(duration.count() - workergc.GetInstrumentationTimeNs() / 1e9);
+
+        gcPauses.Merge(workergc.GetGcPauses());
+        for (auto& record : workergc.GetGcRecords()) {
+            heapBytesBefore += record.heapBytesBefore;
+            liveBytesAfter += record.liveBytesAfter;
+        }
+        totalCollections += workergc.GetGcRecords().size();
+        AppendGcLog(name, iteration++, workergc.GetGcRecords());
     }
+    memorySampler.Stop();
 
     state.counters["TotalControlLoopIterations"] = result.totalIterations;
     state.counters["TotalGcInvocations"] = result.totalGcInvocations;
     state.counters["TotalActiveGcPtrs"] = result.totalActiveGcPtrs;
+    gcPauses.ExportCounters(state, "GcPause");
+    if (totalCollections != 0) {
+        state.counters["GcHeapBytesBefore"] = heapBytesBefore / totalCollections;
+        state.counters["GcLiveBytesAfter"] = liveBytesAfter / totalCollections;
+        state.counters["GcReclaimedBytes"] = (heapBytesBefore - liveBytesAfter) / totalCollections;
+    }
+    state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    memorySampler.Export(state);
+}
+
+/**
+ * @brief Multi-mutator variant of BM_ComplexGc. range(0) mutator threads each run
+ * g_gcMutatorTotalOps operations of the default (norm-workload) matrix on their own subgraph of
+ * range(1) / range(0) vertices, plus a shared cross-cluster region all of them link into.
+ *
+ * memplusplus is not thread-safe: allocations and every SharedGcPtr copy or reset update the
+ * collector's global state, including on a mutator's own subgraph. Mutators therefore run every
+ * operation under one heap lock, i.e. they are serialized. This shows how collection pauses
+ * behave with heap size and with more interleaved mutators, not parallel mutator scaling, hence
+ * SerializedOpsPerSecond. LockWaitRatio shows how much of the mutator time goes to the lock.
+ */
+static void BM_ComplexGcMt(benchmark::State& state)
+{
+    const uint32_t totalMutators = state.range(0);
+    const uint32_t totalVertices = state.range(1);
+
+    // Summed over all iterations
+    WorkerGC::BenchResults total{};
+    bm::utils::LatencyHistogram gcPauses;
+    double wallTimeNs = 0;
+    bm::utils::MemorySampler memorySampler("BM_ComplexGcMt/" + std::to_string(totalMutators) +
+                                           "/" + std::to_string(totalVertices));
+    memorySampler.Start();
+    for (auto _ : state) {
+        BenchmarkAllocatorInitialize(bm::profiles::GetSelectedProfile());
+
+        // Graphs are built sequentially, before any mutator starts
+        WorkerGC::SharedHeap sharedHeap;
+        WorkerGC::CreateCrossClusterRegion(sharedHeap, g_gcSharedRegionVertices);
+        std::vector<std::unique_ptr<WorkerGC>> workers;
+        for (uint32_t mutator = 0; mutator < totalMutators; ++mutator) {
+            workers.push_back(std::make_unique<WorkerGC>(state,
+                                                         g_gcMutatorTotalOps,
+                                                         WorkerGC::c_defaultTransitionMatrix,
+                                                         g_gcXorshiftSeed + mutator,
+                                                         totalVertices / totalMutators,
+                                                         &sharedHeap));
+        }
+
+        std::vector<WorkerGC::BenchResults> results(totalMutators);
+        std::vector<std::thread> threads;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t mutator = 0; mutator < totalMutators; ++mutator) {
+            threads.emplace_back(
+                [&, mutator]() { results[mutator] = workers[mutator]->RunBenchmark(); });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+        state.SetIterationTime(duration.count());
+        wallTimeNs += duration.count() * 1e9;
+
+        for (uint32_t mutator = 0; mutator < totalMutators; ++mutator) {
+            auto& result = results[mutator];
+            total.totalIterations += result.totalIterations;
+            total.totalGcInvocations += result.totalGcInvocations;
+            total.totalActiveGcPtrs = std::max(total.totalActiveGcPtrs, result.totalActiveGcPtrs);
+            total.gcTimeNs += result.gcTimeNs;
+            total.lockWaitNs += result.lockWaitNs;
+            gcPauses.Merge(workers[mutator]->GetGcPauses());
+        }
+    }
+    memorySampler.Stop();
+
+    state.counters["TotalControlLoopIterations"] =
+        benchmark::Counter(total.totalIterations, benchmark::Counter::kAvgIterations);
+    state.counters["TotalGcInvocations"] =
+        benchmark::Counter(total.totalGcInvocations, benchmark::Counter::kAvgIterations);
+    state.counters["TotalActiveGcPtrs"] = total.totalActiveGcPtrs;
+    state.counters["SerializedOpsPerSecond"] =
+        benchmark::Counter(total.totalIterations, benchmark::Counter::kIsRate);
+    gcPauses.ExportCounters(state, "GcPause");
+    // Collections stop every mutator, so they are a share of wall time. Lock waits are per mutator
+    state.counters["GcTimeRatio"] = wallTimeNs > 0 ? total.gcTimeNs / wallTimeNs : 0;
+    state.counters["LockWaitRatio"] =
+        wallTimeNs > 0 ? total.lockWaitNs / (wallTimeNs * totalMutators) : 0;
     state.counters["PeakMemoryUsage"] = bm::utils::GetProcPeakMemoryUsage();
+    memorySampler.Export(state);
 }
 
 #define BENCHMARK_WITH_MATRIX(name, iters, transitions)                                            \
@@ -454,4 +809,11 @@ BENCHMARK_SIMULATE_NORM_WORKLOAD(50'000);
 BENCHMARK_SIMULATE_NORM_WORKLOAD(100'000);
 
 BENCHMARK_SIMULATE_GC_HEAVY(50'000);
-BENCHMARK_SIMULATE_GC_HEAVY(100'000);
\ No newline at end of file
+BENCHMARK_SIMULATE_GC_HEAVY(100'000);
+
+BENCHMARK(BM_ComplexGcMt)
+    ->ArgNames({ "mutators", "vertices" })
+    ->ArgsProduct({ { 1, 2, 4, 8 }, { 1 << 10, 1 << 16, 1 << 20 } })
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(3)
+    ->UseManualTime();
\ No newline at end of file
@@ -1,15 +1,20 @@
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
 #include "benchmark/benchmark.h"
 #include "benchmark_constants.h"
 #include "benchmark_utils.h"
 #include "mpplib/memory_manager.hpp"
 #include "mpplib/mpp.hpp"
 #include "mpplib/shared_gcptr.hpp"
+#include "perf_counters.h"
+#include "pointer_structures.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cstdlib>
+#include <memory>
 #include <random>
+#include <utility>
 
 using namespace mpp;
 
@@ -125,17 +130,22 @@ private:
 #define BENCHMARK_MEM_ACCESS(BM_NAME, RANDOMIZED_LINKED_LIST, DO_LAYOUT)                           \
     static void BM_NAME(benchmark::State& state)                                                   \
     {                                                                                              \
-        mpp::g_memoryManager = std::make_unique<mpp::MemoryManager>();                             \
+        BenchmarkAllocatorFinalize();                                                              \
+        BenchmarkAllocatorInitialize(bm::profiles::GetSelectedProfile());                          \
         Worker<RANDOMIZED_LINKED_LIST, DO_LAYOUT> worker(state, state.range(0));                   \
+        bm::utils::PerfCounters perfCounters;                                                      \
         for (auto _ : state) {                                                                     \
             auto start = std::chrono::high_resolution_clock::now();                                \
+            perfCounters.Start();                                                                  \
             uint32_t tmp = worker.DoBenchmark();                                                   \
             benchmark::DoNotOptimize(tmp);                                                         \
+            perfCounters.Stop();                                                                   \
             auto end = std::chrono::high_resolution_clock::now();                                  \
             auto duration =                                                                        \
                 std::chrono::duration_cast<std::chrono::duration<double>>(end - start);            \
             state.SetIterationTime(duration.count());                                              \
         }                                                                                          \
+        perfCounters.ExportCounters(state);                                                        \
     }                                                                                              \
     BENCHMARK(BM_NAME)                                                                             \
         ->RangeMultiplier(2)                                                                       \
@@ -149,3 +159,48 @@ BENCHMARK_MEM_ACCESS(BM_AccessMemoryRandomizedLinkedList, true, false);
 // Perform layouting
 BENCHMARK_MEM_ACCESS(BM_AccessMemoryDefaultLayoutedLinkedList, false, true);
 BENCHMARK_MEM_ACCESS(BM_AccessMemoryRandomizedLayoutedLinkedList, true, true);
+
+/**
+ * @brief bm::ds pointer policy on top of memplusplus garbage collected pointers. Relayout() is
+ * a full CollectGarbage(), which compacts the heap in traversal order.
+ */
+struct GcPointers
+{
+    template<class T>
+    using Ptr = SharedGcPtr<T>;
+
+    static constexpr bool c_isGarbageCollected = true;
+
+    template<class T, class... Args>
+    static SharedGcPtr<T> Make(Args&&... t_args)
+    {
+        return MakeShared<T>(std::forward<Args>(t_args)...);
+    }
+
+    template<class T>
+    static void Destroy(const SharedGcPtr<T>&)
+    {}
+
+    template<class T>
+    static T* Get(const SharedGcPtr<T>& t_ptr)
+    {
+        return t_ptr.Get();
+    }
+
+    //! @brief Starts over with a fresh heap, through the shim so that the selected profile applies
+    static void Reset()
+    {
+        BenchmarkAllocatorFinalize();
+        BenchmarkAllocatorInitialize(bm::profiles::GetSelectedProfile());
+    }
+
+    static void Relayout()
+    {
+        CollectGarbage();
+    }
+};
+
+// Same structures as benchmark_pointer_structures.cpp, on SharedGcPtr before and after relayout
+static const int s_totalGcTraversalBenchmarks =
+    bm::ds::RegisterTraversalBenchmarks<GcPointers>("/Gc", false) +
+    bm::ds::RegisterTraversalBenchmarks<GcPointers>("/GcRelayout", true);
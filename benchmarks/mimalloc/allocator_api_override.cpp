@@ -1,7 +1,51 @@
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
 #include "mimalloc.h"
 
-void BenchmarkAllocatorInitialize() { return; }
+namespace {
+    //! @brief Option value that leaves mimalloc's default in place
+    constexpr long c_keep = -1;
+
+    struct MimallocProfile {
+        const char* name;
+        long eagerCommit;
+        //! @brief Reset (madvise) free pages, after resetDelay ms
+        long pageReset;
+        long resetDelay;
+        //! @brief Decommit instead of reset, so that the memory leaves the commit charge too
+        long resetDecommits;
+    };
+
+    constexpr MimallocProfile c_profiles[] = {
+        { "default", c_keep, c_keep, c_keep, c_keep },
+        { "no-eager-commit", 0, c_keep, c_keep, c_keep },
+        { "page-reset", c_keep, 1, 0, c_keep },
+        { "lazy-page-reset", c_keep, 1, 1000, c_keep },
+        { "low-memory", 0, 1, 0, 1 },
+    };
+
+    void SetOption(mi_option_t t_option, long t_value) {
+        if (t_value != c_keep)
+            mi_option_set(t_option, t_value);
+    }
+}
+
+// mimalloc reads most options when they are used, so they still apply after its initialization
+bool BenchmarkAllocatorInitialize(const char* t_profile) {
+    const MimallocProfile* profile = bm::profiles::Find(c_profiles, t_profile);
+    if (profile == nullptr)
+        return false;
+
+    SetOption(mi_option_eager_commit, profile->eagerCommit);
+    SetOption(mi_option_page_reset, profile->pageReset);
+    SetOption(mi_option_reset_delay, profile->resetDelay);
+    SetOption(mi_option_reset_decommits, profile->resetDecommits);
+    return true;
+}
+
+const char* const* BenchmarkAllocatorProfiles() {
+    return bm::profiles::Names(c_profiles);
+}
 void BenchmarkAllocatorFinalize() { return; }
 
 void* BenchmarkAllocate(std::size_t t_size) {
@@ -11,3 +55,45 @@ void* BenchmarkAllocate(std::size_t t_size) {
 void BenchmarkDeallocate(void* t_ptr) {
     mi_free(t_ptr);
 }
+
+void BenchmarkThreadInitialize() { return; }
+void BenchmarkThreadFinalize() { return; }
+
+uint32_t BenchmarkAllocatorCapabilities() {
+    return kBenchmarkCapThreadSafe | kBenchmarkCapNativeReallocate |
+           kBenchmarkCapNativeAllocateZeroed | kBenchmarkCapNativeDeallocateSized |
+           kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize) {
+    return mi_realloc(t_ptr, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size) {
+    return mi_malloc_aligned(t_size, t_alignment);
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size) {
+    return mi_calloc(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size) {
+    mi_free_size(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr) {
+    return mi_usable_size(t_ptr);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats) {
+    // mimalloc only tracks committed memory process-wide, there is no cheap "active" counter
+    std::size_t currentCommit = 0;
+    mi_process_info(nullptr, nullptr, nullptr, nullptr, nullptr, &currentCommit, nullptr, nullptr);
+    t_stats.mappedBytes = currentCommit;
+    return true;
+}
+
+bool BenchmarkAllocatorPurge() {
+    mi_collect(true);
+    return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace bm::utils {
+    /**
+     * @brief Bounded lock-free multi-producer/multi-consumer queue (Dmitry Vyukov's design).
+     * Every cell carries a sequence number, so producers and consumers only contend on the
+     * enqueue/dequeue positions and never on a shared lock.
+     * @tparam T Element type (should be trivially copyable, e.g. a pointer)
+     */
+    template<typename T>
+    class MpmcQueue
+    {
+    public:
+        /**
+         * @brief Construct a new MpmcQueue object
+         * @param t_capacity Queue capacity, must be a power of two
+         */
+        explicit MpmcQueue(std::size_t t_capacity)
+            : m_cells(std::make_unique<Cell[]>(t_capacity))
+            , m_mask(t_capacity - 1)
+        {
+            for (std::size_t i = 0; i < t_capacity; ++i) {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+        //! @brief Pushes the element. Returns false if the queue is full.
+        bool TryPush(const T& t_value)
+        {
+            std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = m_cells[pos & m_mask];
+                std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (m_enqueuePos.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.data = t_value;
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        //! @brief Pops the element into t_value. Returns false if the queue is empty.
+        bool TryPop(T& t_value)
+        {
+            std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = m_cells[pos & m_mask];
+                std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (m_dequeuePos.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed)) {
+                        t_value = cell.data;
+                        cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+    private:
+        static constexpr std::size_t c_cacheLineSize = 64;
+
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence;
+            T data;
+        };
+
+        //! @brief Ring buffer of cells
+        std::unique_ptr<Cell[]> m_cells;
+        //! @brief Capacity - 1
+        const std::size_t m_mask;
+
+        //! @brief Next position to push to (own cache line to avoid false sharing)
+        alignas(c_cacheLineSize) std::atomic<std::size_t> m_enqueuePos{ 0 };
+        //! @brief Next position to pop from
+        alignas(c_cacheLineSize) std::atomic<std::size_t> m_dequeuePos{ 0 };
+    };
+}
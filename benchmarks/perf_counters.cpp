@@ -0,0 +1,140 @@
+#include "perf_counters.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bm::utils {
+    namespace {
+        int OpenEvent(uint32_t t_type, uint64_t t_config)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = t_type;
+            attr.config = t_config;
+            attr.disabled = 1;
+            // Kernel time is part of a page fault, but is forbidden for hardware events by the
+            // default perf_event_paranoid
+            attr.exclude_kernel = t_type == PERF_TYPE_SOFTWARE ? 0 : 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        constexpr uint64_t HwCacheConfig(uint64_t t_cache)
+        {
+            return t_cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+    }
+
+    PerfCounters::PerfCounters()
+    {
+        m_fds.fill(-1);
+
+        const char* enabled = std::getenv("MPP_BENCH_PERF_COUNTERS");
+        m_enabled = enabled != nullptr && std::strcmp(enabled, "0") != 0;
+        if (!m_enabled)
+            return;
+
+        m_fds[CYCLES] = OpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        m_fds[INSTRUCTIONS] = OpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        m_fds[LLC_MISSES] = OpenEvent(PERF_TYPE_HW_CACHE, HwCacheConfig(PERF_COUNT_HW_CACHE_LL));
+        m_fds[DTLB_LOAD_MISSES] =
+            OpenEvent(PERF_TYPE_HW_CACHE, HwCacheConfig(PERF_COUNT_HW_CACHE_DTLB));
+        m_fds[MINOR_FAULTS] = OpenEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN);
+        m_fds[MAJOR_FAULTS] = OpenEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ);
+
+        m_useRusage = m_fds[MINOR_FAULTS] < 0 || m_fds[MAJOR_FAULTS] < 0;
+
+        for (int fd : m_fds) {
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        }
+    }
+
+    PerfCounters::~PerfCounters()
+    {
+        for (int fd : m_fds) {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    void PerfCounters::Start()
+    {
+        if (!m_enabled)
+            return;
+
+        if (m_useRusage)
+            getrusage(RUSAGE_THREAD, &m_rusageStart);
+
+        for (int fd : m_fds) {
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void PerfCounters::Stop()
+    {
+        if (!m_enabled)
+            return;
+
+        for (int fd : m_fds) {
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+
+        if (m_useRusage) {
+            struct rusage usage;
+            getrusage(RUSAGE_THREAD, &usage);
+            m_rusageMinorFaults += usage.ru_minflt - m_rusageStart.ru_minflt;
+            m_rusageMajorFaults += usage.ru_majflt - m_rusageStart.ru_majflt;
+        }
+    }
+
+    double PerfCounters::ReadEvent(Event t_event) const
+    {
+        // value, time enabled, time running
+        uint64_t values[3] = {};
+        if (read(m_fds[t_event], values, sizeof(values)) != sizeof(values) || values[2] == 0)
+            return 0;
+
+        return static_cast<double>(values[0]) * values[1] / values[2];
+    }
+
+    void PerfCounters::ExportCounters(benchmark::State& t_state) const
+    {
+        if (!m_enabled)
+            return;
+
+        constexpr const char* c_names[Event::COUNT] = { "Cycles",         "Instructions",
+                                                         "LLCMisses",      "DTLBLoadMisses",
+                                                         "MinorFaults",    "MajorFaults" };
+        for (int event = 0; event < Event::COUNT; ++event) {
+            if (m_fds[event] >= 0) {
+                t_state.counters[c_names[event]] = benchmark::Counter(
+                    ReadEvent(static_cast<Event>(event)), benchmark::Counter::kAvgIterations);
+            }
+        }
+
+        // Counters of multi-threaded runs are summed over threads, a ratio has to be averaged
+        if (m_fds[CYCLES] >= 0 && m_fds[INSTRUCTIONS] >= 0) {
+            double cycles = ReadEvent(CYCLES);
+            t_state.counters["IPC"] = benchmark::Counter(
+                cycles > 0 ? ReadEvent(INSTRUCTIONS) / cycles : 0, benchmark::Counter::kAvgThreads);
+        }
+
+        if (m_useRusage) {
+            t_state.counters["MinorFaults"] =
+                benchmark::Counter(m_rusageMinorFaults, benchmark::Counter::kAvgIterations);
+            t_state.counters["MajorFaults"] =
+                benchmark::Counter(m_rusageMajorFaults, benchmark::Counter::kAvgIterations);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "benchmark/benchmark.h"
+
+#include <array>
+#include <cstdint>
+#include <sys/resource.h>
+
+namespace bm::utils {
+    /**
+     * @brief Hardware/software event counters (perf_event_open) around a benchmark's timed region.
+     * Collects cycles, instructions, LLC load misses, dTLB load misses and minor/major page
+     * faults of the calling thread. Events the kernel refuses (no PMU, perf_event_paranoid,
+     * containers) are skipped; if page fault events are unavailable they come from getrusage().
+     *
+     * Collection is opt-in with MPP_BENCH_PERF_COUNTERS=1, otherwise Start()/Stop() do nothing
+     * and no counters are exported.
+     */
+    class PerfCounters
+    {
+    public:
+        PerfCounters();
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+        ~PerfCounters();
+
+        //! @brief Starts (resumes) counting.
+        void Start();
+
+        //! @brief Stops (pauses) counting. Values accumulate over Start()/Stop() pairs.
+        void Stop();
+
+        /**
+         * @brief Exports per-iteration Cycles, Instructions, IPC, LLCMisses, DTLBLoadMisses,
+         * MinorFaults and MajorFaults counters (only the ones that were collected).
+         */
+        void ExportCounters(benchmark::State& t_state) const;
+
+    private:
+        enum Event
+        {
+            CYCLES = 0,
+            INSTRUCTIONS,
+            LLC_MISSES,
+            DTLB_LOAD_MISSES,
+            MINOR_FAULTS,
+            MAJOR_FAULTS,
+            COUNT
+        };
+
+        bool m_enabled = false;
+        std::array<int, Event::COUNT> m_fds;
+        //! @brief getrusage() fallback for page faults
+        bool m_useRusage = false;
+        struct rusage m_rusageStart = {};
+        uint64_t m_rusageMinorFaults = 0;
+        uint64_t m_rusageMajorFaults = 0;
+
+        //! @brief Reads an event, scaled up if the kernel multiplexed it.
+        double ReadEvent(Event t_event) const;
+    };
+}
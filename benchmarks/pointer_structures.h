@@ -0,0 +1,608 @@
+#pragma once
+
+#include "allocator_api_override.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+#include "benchmark_utils.h"
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Pointer-based data structures (binary search tree, B-tree, chained hash table, layered
+ * DAG) used to measure traversal speed depending on where the allocator placed their nodes.
+ *
+ * Structures are parametrized by a pointer policy, so the same code runs on raw pointers from
+ * BenchmarkAllocate() (every allocator) and on mpp::SharedGcPtr (memplusplus, before and after
+ * the relayout done by CollectGarbage()). A policy provides:
+ *  - Ptr<T> - owning pointer type stored inside nodes,
+ *  - Make<T>(args...) / Destroy(ptr) / Get(ptr) - allocation, release and raw access,
+ *  - Reset() / Relayout() - heap reset before building and relayout after it,
+ *  - c_isGarbageCollected - if true, nodes are never destroyed explicitly.
+ *
+ * Nodes are always allocated in random key order, so without relayout the in-order neighbours
+ * are scattered over the heap, like in a long-running program.
+ */
+namespace bm::ds {
+    //! @brief Plain pointers to memory from BenchmarkAllocate().
+    struct RawPointers
+    {
+        template<class T>
+        using Ptr = T*;
+
+        static constexpr bool c_isGarbageCollected = false;
+
+        template<class T, class... Args>
+        static T* Make(Args&&... t_args)
+        {
+            return new (BenchmarkAllocate(sizeof(T))) T(std::forward<Args>(t_args)...);
+        }
+
+        template<class T>
+        static void Destroy(T* t_ptr)
+        {
+            t_ptr->~T();
+            BenchmarkDeallocate(t_ptr);
+        }
+
+        template<class T>
+        static T* Get(T* t_ptr)
+        {
+            return t_ptr;
+        }
+
+        static void Reset() {}
+        static void Relayout() {}
+    };
+
+    enum class TraversalOrder
+    {
+        //! @brief Visit every node in key (or storage) order.
+        IN_ORDER = 0,
+        //! @brief Look up random keys (random root-to-leaf walks for the DAG).
+        RANDOM
+    };
+
+    //! @brief Returns keys 1, 3, 5, ... (2 * t_total - 1) in random order.
+    inline std::vector<uint64_t> ShuffledKeys(uint32_t t_total, uint64_t t_seed)
+    {
+        std::vector<uint64_t> keys(t_total);
+        for (uint32_t i = 0; i < t_total; ++i)
+            keys[i] = 2 * i + 1;
+        std::shuffle(keys.begin(), keys.end(), std::minstd_rand(t_seed));
+        return keys;
+    }
+
+    //! @brief Unbalanced binary search tree, balanced enough by the random insertion order.
+    template<class Policy>
+    class BinarySearchTree
+    {
+    public:
+        static constexpr const char* c_name = "BinarySearchTree";
+
+        BinarySearchTree(uint32_t t_totalNodes, uint64_t t_seed)
+            : m_lookups(ShuffledKeys(t_totalNodes, t_seed + 1))
+        {
+            for (uint64_t key : ShuffledKeys(t_totalNodes, t_seed))
+                Insert(key);
+            m_stack.reserve(t_totalNodes);
+        }
+
+        BinarySearchTree(const BinarySearchTree&) = delete;
+        BinarySearchTree& operator=(const BinarySearchTree&) = delete;
+
+        ~BinarySearchTree()
+        {
+            if constexpr (!Policy::c_isGarbageCollected) {
+                m_stack.clear();
+                if (m_root != nullptr)
+                    m_stack.push_back(m_root);
+                while (!m_stack.empty()) {
+                    Node* node = m_stack.back();
+                    m_stack.pop_back();
+                    if (node->left != nullptr)
+                        m_stack.push_back(node->left);
+                    if (node->right != nullptr)
+                        m_stack.push_back(node->right);
+                    Policy::Destroy(node);
+                }
+            }
+        }
+
+        uint64_t Traverse(TraversalOrder t_order)
+        {
+            uint64_t sum = 0;
+            if (t_order == TraversalOrder::IN_ORDER) {
+                m_stack.clear();
+                Node* node = Policy::Get(m_root);
+                while (node != nullptr || !m_stack.empty()) {
+                    while (node != nullptr) {
+                        m_stack.push_back(node);
+                        node = Policy::Get(node->left);
+                    }
+                    node = m_stack.back();
+                    m_stack.pop_back();
+                    sum += node->value;
+                    node = Policy::Get(node->right);
+                }
+            } else {
+                for (uint64_t key : m_lookups) {
+                    Node* node = Policy::Get(m_root);
+                    while (node != nullptr && node->key != key)
+                        node = Policy::Get(key < node->key ? node->left : node->right);
+                    sum += node != nullptr ? node->value : 0;
+                }
+            }
+            return sum;
+        }
+
+    private:
+        struct Node
+        {
+            uint64_t key;
+            uint64_t value;
+            typename Policy::template Ptr<Node> left{};
+            typename Policy::template Ptr<Node> right{};
+
+            explicit Node(uint64_t t_key)
+                : key(t_key)
+                , value(t_key ^ 0x1337AF12)
+            {}
+        };
+
+        typename Policy::template Ptr<Node> m_root{};
+        std::vector<uint64_t> m_lookups;
+        std::vector<Node*> m_stack;
+
+        void Insert(uint64_t t_key)
+        {
+            if (m_root == nullptr) {
+                m_root = Policy::template Make<Node>(t_key);
+                return;
+            }
+
+            Node* node = Policy::Get(m_root);
+            while (true) {
+                auto& child = t_key < node->key ? node->left : node->right;
+                if (child == nullptr) {
+                    child = Policy::template Make<Node>(t_key);
+                    return;
+                }
+                node = Policy::Get(child);
+            }
+        }
+    };
+
+    //! @brief B-tree with up to 15 keys per node (minimum degree 8).
+    template<class Policy>
+    class BTree
+    {
+    public:
+        static constexpr const char* c_name = "BTree";
+
+        BTree(uint32_t t_totalNodes, uint64_t t_seed)
+            : m_lookups(ShuffledKeys(t_totalNodes, t_seed + 1))
+        {
+            // t_totalNodes is the number of keys, like for the other structures
+            for (uint64_t key : ShuffledKeys(t_totalNodes, t_seed))
+                Insert(key);
+        }
+
+        BTree(const BTree&) = delete;
+        BTree& operator=(const BTree&) = delete;
+
+        ~BTree()
+        {
+            if constexpr (!Policy::c_isGarbageCollected) {
+                if (m_root != nullptr)
+                    DestroySubtree(m_root);
+            }
+        }
+
+        uint64_t Traverse(TraversalOrder t_order)
+        {
+            if (t_order == TraversalOrder::IN_ORDER)
+                return m_root != nullptr ? SumSubtree(Policy::Get(m_root)) : 0;
+
+            uint64_t sum = 0;
+            for (uint64_t key : m_lookups)
+                sum += Find(key);
+            return sum;
+        }
+
+    private:
+        static constexpr uint32_t c_minDegree = 8;
+        static constexpr uint32_t c_maxKeys = 2 * c_minDegree - 1;
+
+        struct Node
+        {
+            uint32_t totalKeys = 0;
+            bool leaf = true;
+            std::array<uint64_t, c_maxKeys> keys{};
+            std::array<uint64_t, c_maxKeys> values{};
+            std::array<typename Policy::template Ptr<Node>, c_maxKeys + 1> children{};
+        };
+
+        typename Policy::template Ptr<Node> m_root{};
+        std::vector<uint64_t> m_lookups;
+
+        void Insert(uint64_t t_key)
+        {
+            if (m_root == nullptr)
+                m_root = Policy::template Make<Node>();
+
+            if (Policy::Get(m_root)->totalKeys == c_maxKeys) {
+                auto newRoot = Policy::template Make<Node>();
+                Policy::Get(newRoot)->leaf = false;
+                Policy::Get(newRoot)->children[0] = m_root;
+                SplitChild(Policy::Get(newRoot), 0);
+                m_root = newRoot;
+            }
+
+            InsertNonFull(Policy::Get(m_root), t_key);
+        }
+
+        //! @brief Splits the full child t_idx of t_parent, moving its median key up.
+        void SplitChild(Node* t_parent, uint32_t t_idx)
+        {
+            Node* child = Policy::Get(t_parent->children[t_idx]);
+            auto sibling = Policy::template Make<Node>();
+            Node* right = Policy::Get(sibling);
+            right->leaf = child->leaf;
+            right->totalKeys = c_minDegree - 1;
+            for (uint32_t i = 0; i < c_minDegree - 1; ++i) {
+                right->keys[i] = child->keys[i + c_minDegree];
+                right->values[i] = child->values[i + c_minDegree];
+            }
+            if (!child->leaf) {
+                for (uint32_t i = 0; i < c_minDegree; ++i) {
+                    right->children[i] = child->children[i + c_minDegree];
+                    child->children[i + c_minDegree] = nullptr;
+                }
+            }
+            child->totalKeys = c_minDegree - 1;
+
+            for (uint32_t i = t_parent->totalKeys; i > t_idx; --i)
+                t_parent->children[i + 1] = t_parent->children[i];
+            t_parent->children[t_idx + 1] = sibling;
+            for (uint32_t i = t_parent->totalKeys; i > t_idx; --i) {
+                t_parent->keys[i] = t_parent->keys[i - 1];
+                t_parent->values[i] = t_parent->values[i - 1];
+            }
+            t_parent->keys[t_idx] = child->keys[c_minDegree - 1];
+            t_parent->values[t_idx] = child->values[c_minDegree - 1];
+            ++t_parent->totalKeys;
+        }
+
+        void InsertNonFull(Node* t_node, uint64_t t_key)
+        {
+            while (true) {
+                uint32_t idx = t_node->totalKeys;
+                if (t_node->leaf) {
+                    for (; idx > 0 && t_node->keys[idx - 1] > t_key; --idx) {
+                        t_node->keys[idx] = t_node->keys[idx - 1];
+                        t_node->values[idx] = t_node->values[idx - 1];
+                    }
+                    t_node->keys[idx] = t_key;
+                    t_node->values[idx] = t_key ^ 0x1337AF12;
+                    ++t_node->totalKeys;
+                    return;
+                }
+
+                while (idx > 0 && t_node->keys[idx - 1] > t_key)
+                    --idx;
+                if (Policy::Get(t_node->children[idx])->totalKeys == c_maxKeys) {
+                    SplitChild(t_node, idx);
+                    if (t_key > t_node->keys[idx])
+                        ++idx;
+                }
+                t_node = Policy::Get(t_node->children[idx]);
+            }
+        }
+
+        uint64_t Find(uint64_t t_key) const
+        {
+            Node* node = Policy::Get(m_root);
+            while (node != nullptr) {
+                uint32_t idx = 0;
+                while (idx < node->totalKeys && node->keys[idx] < t_key)
+                    ++idx;
+                if (idx < node->totalKeys && node->keys[idx] == t_key)
+                    return node->values[idx];
+                if (node->leaf)
+                    return 0;
+                node = Policy::Get(node->children[idx]);
+            }
+            return 0;
+        }
+
+        uint64_t SumSubtree(Node* t_node) const
+        {
+            uint64_t sum = 0;
+            for (uint32_t i = 0; i < t_node->totalKeys; ++i) {
+                if (!t_node->leaf)
+                    sum += SumSubtree(Policy::Get(t_node->children[i]));
+                sum += t_node->values[i];
+            }
+            if (!t_node->leaf)
+                sum += SumSubtree(Policy::Get(t_node->children[t_node->totalKeys]));
+            return sum;
+        }
+
+        void DestroySubtree(Node* t_node)
+        {
+            if (!t_node->leaf) {
+                for (uint32_t i = 0; i <= t_node->totalKeys; ++i)
+                    DestroySubtree(Policy::Get(t_node->children[i]));
+            }
+            Policy::Destroy(t_node);
+        }
+    };
+
+    //! @brief Hash table with separate chaining, g_traversalHashChainLength entries per bucket.
+    template<class Policy>
+    class ChainedHashTable
+    {
+    public:
+        static constexpr const char* c_name = "ChainedHashTable";
+
+        ChainedHashTable(uint32_t t_totalNodes, uint64_t t_seed)
+            : m_lookups(ShuffledKeys(t_totalNodes, t_seed + 1))
+        {
+            uint32_t totalBuckets = 1;
+            while (totalBuckets * g_traversalHashChainLength < t_totalNodes)
+                totalBuckets <<= 1;
+            m_buckets.resize(totalBuckets);
+            m_bucketMask = totalBuckets - 1;
+
+            for (uint64_t key : ShuffledKeys(t_totalNodes, t_seed)) {
+                auto& bucket = m_buckets[GetBucketIdx(key)];
+                auto entry = Policy::template Make<Entry>(key);
+                Policy::Get(entry)->next = bucket;
+                bucket = entry;
+            }
+        }
+
+        ChainedHashTable(const ChainedHashTable&) = delete;
+        ChainedHashTable& operator=(const ChainedHashTable&) = delete;
+
+        ~ChainedHashTable()
+        {
+            if constexpr (!Policy::c_isGarbageCollected) {
+                for (Entry* entry : m_buckets) {
+                    while (entry != nullptr) {
+                        Entry* next = entry->next;
+                        Policy::Destroy(entry);
+                        entry = next;
+                    }
+                }
+            }
+        }
+
+        uint64_t Traverse(TraversalOrder t_order)
+        {
+            uint64_t sum = 0;
+            if (t_order == TraversalOrder::IN_ORDER) {
+                for (auto& bucket : m_buckets) {
+                    for (Entry* entry = Policy::Get(bucket); entry != nullptr;
+                         entry = Policy::Get(entry->next))
+                        sum += entry->value;
+                }
+            } else {
+                for (uint64_t key : m_lookups) {
+                    Entry* entry = Policy::Get(m_buckets[GetBucketIdx(key)]);
+                    while (entry != nullptr && entry->key != key)
+                        entry = Policy::Get(entry->next);
+                    sum += entry != nullptr ? entry->value : 0;
+                }
+            }
+            return sum;
+        }
+
+    private:
+        struct Entry
+        {
+            uint64_t key;
+            uint64_t value;
+            typename Policy::template Ptr<Entry> next{};
+
+            explicit Entry(uint64_t t_key)
+                : key(t_key)
+                , value(t_key ^ 0x1337AF12)
+            {}
+        };
+
+        std::vector<typename Policy::template Ptr<Entry>> m_buckets;
+        uint64_t m_bucketMask = 0;
+        std::vector<uint64_t> m_lookups;
+
+        std::size_t GetBucketIdx(uint64_t t_key) const
+        {
+            return (t_key * UINT64_C(0x9E3779B97F4A7C15) >> 32) & m_bucketMask;
+        }
+    };
+
+    /**
+     * @brief Layered DAG: g_traversalDagLayerWidth nodes per layer, every node points to the
+     * node below it and to up to c_fanout - 1 random nodes of the next layer, so nodes are shared
+     * between many parents.
+     */
+    template<class Policy>
+    class LayeredDag
+    {
+    public:
+        static constexpr const char* c_name = "LayeredDag";
+
+        LayeredDag(uint32_t t_totalNodes, uint64_t t_seed)
+            : m_rngState(t_seed)
+        {
+            const uint32_t width = g_traversalDagLayerWidth;
+            m_totalLayers = std::max<uint32_t>(t_totalNodes / width, 1);
+
+            // Allocate in random order, then link layer by layer
+            std::vector<uint32_t> allocationOrder(m_totalLayers * width);
+            std::iota(allocationOrder.begin(), allocationOrder.end(), 0);
+            std::shuffle(allocationOrder.begin(), allocationOrder.end(), std::minstd_rand(t_seed));
+            std::vector<typename Policy::template Ptr<Node>> nodes(allocationOrder.size());
+            for (uint32_t idx : allocationOrder)
+                nodes[idx] = Policy::template Make<Node>(idx);
+
+            for (uint32_t layer = 0; layer + 1 < m_totalLayers; ++layer) {
+                for (uint32_t i = 0; i < width; ++i) {
+                    Node* node = Policy::Get(nodes[layer * width + i]);
+                    node->children[0] = nodes[(layer + 1) * width + i];
+                    for (uint32_t child = 1; child < c_fanout; ++child) {
+                        uint64_t other = bm::utils::XorshiftNext(m_rngState, uint64_t(0), uint64_t(width - 1));
+                        node->children[child] = nodes[(layer + 1) * width + other];
+                    }
+                }
+            }
+
+            // Only the first layer stays rooted, everything else is reachable through it
+            m_roots.assign(nodes.begin(), nodes.begin() + width);
+            if constexpr (!Policy::c_isGarbageCollected)
+                m_allNodes = std::move(nodes);
+
+            m_stack.reserve(allocationOrder.size());
+        }
+
+        LayeredDag(const LayeredDag&) = delete;
+        LayeredDag& operator=(const LayeredDag&) = delete;
+
+        ~LayeredDag()
+        {
+            if constexpr (!Policy::c_isGarbageCollected) {
+                for (Node* node : m_allNodes)
+                    Policy::Destroy(node);
+            }
+        }
+
+        uint64_t Traverse(TraversalOrder t_order)
+        {
+            uint64_t sum = 0;
+            if (t_order == TraversalOrder::IN_ORDER) {
+                // Depth-first, every shared node is visited once
+                ++m_epoch;
+                m_stack.clear();
+                for (auto& root : m_roots)
+                    m_stack.push_back(Policy::Get(root));
+                while (!m_stack.empty()) {
+                    Node* node = m_stack.back();
+                    m_stack.pop_back();
+                    if (node == nullptr || node->visitEpoch == m_epoch)
+                        continue;
+                    node->visitEpoch = m_epoch;
+                    sum += node->value;
+                    for (auto& child : node->children)
+                        m_stack.push_back(Policy::Get(child));
+                }
+            } else {
+                // Random root-to-leaf walks, about as many nodes as the in-order traversal
+                const uint32_t totalWalks = m_roots.size();
+                for (uint32_t walk = 0; walk < totalWalks; ++walk) {
+                    Node* node = Policy::Get(m_roots[walk]);
+                    while (node != nullptr) {
+                        sum += node->value;
+                        m_rngState ^= m_rngState << 13;
+                        m_rngState ^= m_rngState >> 7;
+                        m_rngState ^= m_rngState << 17;
+                        node = Policy::Get(node->children[m_rngState % c_fanout]);
+                    }
+                }
+            }
+            return sum;
+        }
+
+    private:
+        static constexpr uint32_t c_fanout = 4;
+
+        struct Node
+        {
+            uint64_t value;
+            uint64_t visitEpoch = 0;
+            std::array<typename Policy::template Ptr<Node>, c_fanout> children{};
+
+            explicit Node(uint64_t t_value)
+                : value(t_value ^ 0x1337AF12)
+            {}
+        };
+
+        std::vector<typename Policy::template Ptr<Node>> m_roots;
+        //! @brief Every node, only kept when nodes have to be destroyed explicitly
+        std::vector<typename Policy::template Ptr<Node>> m_allNodes;
+        std::vector<Node*> m_stack;
+        uint32_t m_totalLayers;
+        uint64_t m_epoch = 0;
+        uint64_t m_rngState;
+    };
+
+    /**
+     * @brief Builds the structure with range(0) nodes (optionally relayouts the heap) and then
+     * measures a single traversal per iteration.
+     */
+    template<class Structure, class Policy>
+    void BM_TraverseStructure(benchmark::State& state, TraversalOrder t_order, bool t_relayout)
+    {
+        Policy::Reset();
+        Structure structure(state.range(0), g_traversalXorshiftSeed);
+        if (t_relayout)
+            Policy::Relayout();
+
+        bm::utils::PerfCounters perfCounters;
+        for (auto _ : state) {
+            auto start = std::chrono::high_resolution_clock::now();
+            perfCounters.Start();
+            uint64_t result = structure.Traverse(t_order);
+            benchmark::DoNotOptimize(result);
+            perfCounters.Stop();
+            auto end = std::chrono::high_resolution_clock::now();
+            state.SetIterationTime(
+                std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());
+        }
+
+        state.counters["Nodes"] = state.range(0);
+        perfCounters.ExportCounters(state);
+    }
+
+    /**
+     * @brief Registers in-order and random traversals of every structure as
+     * "BM_Traverse<Structure>/<InOrder|Random><t_suffix>/<nodes>".
+     * @return Number of registered benchmarks
+     */
+    template<class Policy>
+    int RegisterTraversalBenchmarks(const std::string& t_suffix, bool t_relayout)
+    {
+        int registered = 0;
+        auto registerStructure = [&](auto* t_tag) {
+            using Structure = std::remove_pointer_t<decltype(t_tag)>;
+            for (auto order : { TraversalOrder::IN_ORDER, TraversalOrder::RANDOM }) {
+                std::string name = std::string("BM_Traverse") + Structure::c_name +
+                                   (order == TraversalOrder::IN_ORDER ? "/InOrder" : "/Random") +
+                                   t_suffix;
+                benchmark::RegisterBenchmark(
+                    name.c_str(), BM_TraverseStructure<Structure, Policy>, order, t_relayout)
+                    ->RangeMultiplier(8)
+                    ->Range(g_traversalNodesRangeStart, g_traversalNodesRangeEnd)
+                    ->Unit(benchmark::kMicrosecond)
+                    ->UseManualTime();
+                ++registered;
+            }
+        };
+
+        registerStructure(static_cast<BinarySearchTree<Policy>*>(nullptr));
+        registerStructure(static_cast<BTree<Policy>*>(nullptr));
+        registerStructure(static_cast<ChainedHashTable<Policy>*>(nullptr));
+        registerStructure(static_cast<LayeredDag<Policy>*>(nullptr));
+        return registered;
+    }
+}
@@ -1,11 +1,36 @@
+#include "allocator_api_fallback.h"
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
 #include "malloc.h"
 #include <cstdint>
+#include <cstdlib>
 
-void BenchmarkAllocatorInitialize()
+#ifdef MPP_BENCH_EXPECT_TCACHE_TUNABLES
+#include <cstring>
+#include <iostream>
+#endif
+
+bool BenchmarkAllocatorInitialize(const char* t_profile)
 {
-    return;
+    if (!bm::profiles::IsDefault(t_profile))
+        return false;
+
+#ifdef MPP_BENCH_EXPECT_TCACHE_TUNABLES
+    // ptmalloc2-tcache target: without the tunables its results would be the ones of ptmalloc2
+    const char* tunables = std::getenv("GLIBC_TUNABLES");
+    if (tunables == nullptr || std::strstr(tunables, MPP_BENCH_GLIBC_TUNABLES) == nullptr) {
+        std::cerr << "GLIBC_TUNABLES doesn't contain " << MPP_BENCH_GLIBC_TUNABLES
+                  << ", glibc runs with its default tcache" << std::endl;
+    }
+#endif
+    return true;
+}
+
+const char* const* BenchmarkAllocatorProfiles()
+{
+    return bm::profiles::DefaultOnly();
 }
+
 void BenchmarkAllocatorFinalize()
 {
     return;
@@ -20,3 +45,67 @@ void BenchmarkDeallocate(void* t_ptr)
 {
     free(t_ptr);
 }
+
+void BenchmarkThreadInitialize()
+{
+    return;
+}
+
+void BenchmarkThreadFinalize()
+{
+    return;
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    // glibc has no sized free (free_sized) in the versions we benchmark
+    return kBenchmarkCapThreadSafe | kBenchmarkCapNativeReallocate |
+           kBenchmarkCapNativeAllocateZeroed | kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return realloc(t_ptr, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, t_alignment, t_size) != 0)
+        return nullptr;
+    return ptr;
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return calloc(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    bm::fallback::DeallocateSized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    return malloc_usable_size(t_ptr);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+    // mallinfo() walks all arenas. Its int fields overflow past 2 GiB, prefer mallinfo2()
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+#else
+    struct mallinfo info = mallinfo();
+#endif
+    t_stats.activeBytes = static_cast<std::size_t>(info.uordblks) + info.hblkhd;
+    t_stats.mappedBytes = static_cast<std::size_t>(info.arena) + info.hblkhd;
+    return true;
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    malloc_trim(0);
+    return true;
+}
@@ -1,8 +1,15 @@
+#include "allocator_api_fallback.h"
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
 #include <cstdlib>
 #include "malloc-2.8.3.h"
 
-void BenchmarkAllocatorInitialize() { return; }
+bool BenchmarkAllocatorInitialize(const char* t_profile) {
+    return bm::profiles::IsDefault(t_profile);
+}
+const char* const* BenchmarkAllocatorProfiles() {
+    return bm::profiles::DefaultOnly();
+}
 void BenchmarkAllocatorFinalize() { return; }
 
 void* BenchmarkAllocate(std::size_t t_size) {
@@ -12,3 +19,43 @@ void* BenchmarkAllocate(std::size_t t_size) {
 void BenchmarkDeallocate(void* t_ptr) {
     dlfree(t_ptr);
 }
+
+void BenchmarkThreadInitialize() { return; }
+void BenchmarkThreadFinalize() { return; }
+
+uint32_t BenchmarkAllocatorCapabilities() {
+    return kBenchmarkCapThreadSafe | kBenchmarkCapNativeReallocate |
+           kBenchmarkCapNativeAllocateZeroed | kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize) {
+    return dlrealloc(t_ptr, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size) {
+    return dlmemalign(t_alignment, t_size);
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size) {
+    return dlcalloc(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size) {
+    bm::fallback::DeallocateSized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr) {
+    return dlmalloc_usable_size(t_ptr);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats) {
+    struct mallinfo info = dlmallinfo();
+    t_stats.activeBytes = static_cast<std::size_t>(info.uordblks) + info.hblkhd;
+    t_stats.mappedBytes = static_cast<std::size_t>(info.arena) + info.hblkhd;
+    return true;
+}
+
+bool BenchmarkAllocatorPurge() {
+    dlmalloc_trim(0);
+    return true;
+}
@@ -1,10 +1,42 @@
+#include "allocator_api_fallback.h"
 #include "allocator_api_override.h"
+#include "allocator_profiles.h"
 #include "rpmalloc.h"
 #include <cstdlib>
 
-void BenchmarkAllocatorInitialize()
+namespace {
+    struct RpmallocProfile
+    {
+        const char* name;
+        int enableHugePages;
+        //! @brief Spans mapped per call to mmap (0: rpmalloc's default)
+        std::size_t spanMapCount;
+    };
+
+    constexpr RpmallocProfile c_profiles[] = {
+        { "default", 0, 0 },
+        { "huge-pages", 1, 0 },
+        { "span-map-16", 0, 16 },
+        { "span-map-256", 0, 256 },
+    };
+}
+
+bool BenchmarkAllocatorInitialize(const char* t_profile)
+{
+    const RpmallocProfile* profile = bm::profiles::Find(c_profiles, t_profile);
+    if (profile == nullptr)
+        return false;
+
+    // Zeroed fields keep their defaults
+    rpmalloc_config_t config{};
+    config.enable_huge_pages = profile->enableHugePages;
+    config.span_map_count = profile->spanMapCount;
+    return rpmalloc_initialize_config(&config) == 0;
+}
+
+const char* const* BenchmarkAllocatorProfiles()
 {
-    rpmalloc_initialize();
+    return bm::profiles::Names(c_profiles);
 }
 
 void BenchmarkAllocatorFinalize()
@@ -21,3 +53,74 @@ void BenchmarkDeallocate(void* t_ptr)
 {
     rpfree(t_ptr);
 }
+
+//! @brief Set if the current thread heap was created by BenchmarkThreadInitialize().
+static thread_local bool t_threadHeapOwned = false;
+
+void BenchmarkThreadInitialize()
+{
+    if (!rpmalloc_is_thread_initialized()) {
+        rpmalloc_thread_initialize();
+        t_threadHeapOwned = true;
+    }
+}
+
+void BenchmarkThreadFinalize()
+{
+    // Never tear down the heap of the thread that called BenchmarkAllocatorInitialize().
+    if (t_threadHeapOwned) {
+        rpmalloc_thread_finalize(1);
+        t_threadHeapOwned = false;
+    }
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    return kBenchmarkCapThreadSafe | kBenchmarkCapNativeReallocate |
+           kBenchmarkCapNativeAllocateZeroed | kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return rprealloc(t_ptr, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    return rpaligned_alloc(t_alignment, t_size);
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return rpcalloc(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    bm::fallback::DeallocateSized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    return rpmalloc_usable_size(t_ptr);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+#if defined(ENABLE_STATISTICS) && ENABLE_STATISTICS
+    rpmalloc_global_statistics_t stats;
+    rpmalloc_global_statistics(&stats);
+    t_stats.mappedBytes = stats.mapped;
+    t_stats.activeBytes = stats.mapped - stats.cached;
+    return true;
+#else
+    // Global counters are only maintained with ENABLE_STATISTICS (MPP_BENCH_ALLOCATOR_STATS=ON)
+    return false;
+#endif
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    // Spans are only unmapped when caches overflow, there is no API to flush them
+    return false;
+}
@@ -0,0 +1,84 @@
+#include "allocator_api_override.h"
+#include "allocator_profiles.h"
+#include <snmalloc/snmalloc.h>
+
+bool BenchmarkAllocatorInitialize(const char* t_profile)
+{
+    return bm::profiles::IsDefault(t_profile);
+}
+
+const char* const* BenchmarkAllocatorProfiles()
+{
+    return bm::profiles::DefaultOnly();
+}
+
+void BenchmarkAllocatorFinalize()
+{
+    return;
+}
+
+void* BenchmarkAllocate(std::size_t t_size)
+{
+    return snmalloc::libc::malloc(t_size);
+}
+
+// Chunks freed by another thread are batched and sent back to the owning allocator as messages,
+// BM_CrossThreadFree measures exactly this path
+void BenchmarkDeallocate(void* t_ptr)
+{
+    snmalloc::libc::free(t_ptr);
+}
+
+void BenchmarkThreadInitialize()
+{
+    return;
+}
+
+void BenchmarkThreadFinalize()
+{
+    return;
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    return kBenchmarkCapThreadSafe | kBenchmarkCapNativeReallocate |
+           kBenchmarkCapNativeAllocateZeroed | kBenchmarkCapNativeDeallocateSized |
+           kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return snmalloc::libc::realloc(t_ptr, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    return snmalloc::libc::memalign(t_alignment, t_size);
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return snmalloc::libc::calloc(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    snmalloc::libc::free_sized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    return snmalloc::libc::malloc_usable_size(t_ptr);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+    // snmalloc only exposes its usage through the backend of the active configuration, which
+    // isn't a stable API. RSS sampling still works.
+    return false;
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    return false;
+}
@@ -0,0 +1,92 @@
+#include "allocator_api_override.h"
+#include "allocator_profiles.h"
+#include <gperftools/malloc_extension_c.h>
+#include <gperftools/tcmalloc.h>
+
+bool BenchmarkAllocatorInitialize(const char* t_profile)
+{
+    return bm::profiles::IsDefault(t_profile);
+}
+
+const char* const* BenchmarkAllocatorProfiles()
+{
+    return bm::profiles::DefaultOnly();
+}
+
+void BenchmarkAllocatorFinalize()
+{
+    return;
+}
+
+void* BenchmarkAllocate(std::size_t t_size)
+{
+    return tc_malloc(t_size);
+}
+
+void BenchmarkDeallocate(void* t_ptr)
+{
+    tc_free(t_ptr);
+}
+
+void BenchmarkThreadInitialize()
+{
+    return;
+}
+
+void BenchmarkThreadFinalize()
+{
+    return;
+}
+
+uint32_t BenchmarkAllocatorCapabilities()
+{
+    return kBenchmarkCapThreadSafe | kBenchmarkCapNativeReallocate |
+           kBenchmarkCapNativeAllocateZeroed | kBenchmarkCapNativeDeallocateSized |
+           kBenchmarkCapAllocateAligned;
+}
+
+void* BenchmarkReallocate(void* t_ptr, std::size_t t_oldSize, std::size_t t_newSize)
+{
+    return tc_realloc(t_ptr, t_newSize);
+}
+
+void* BenchmarkAllocateAligned(std::size_t t_alignment, std::size_t t_size)
+{
+    return tc_memalign(t_alignment, t_size);
+}
+
+void* BenchmarkAllocateZeroed(std::size_t t_count, std::size_t t_size)
+{
+    return tc_calloc(t_count, t_size);
+}
+
+void BenchmarkDeallocateSized(void* t_ptr, std::size_t t_size)
+{
+    tc_free_sized(t_ptr, t_size);
+}
+
+std::size_t BenchmarkUsableSize(void* t_ptr)
+{
+    return tc_malloc_size(t_ptr);
+}
+
+bool BenchmarkAllocatorGetStats(BenchmarkAllocatorStats& t_stats)
+{
+    // heap_size includes pages already released to the OS, they don't count as mapped
+    std::size_t heapSize = 0;
+    std::size_t unmappedBytes = 0;
+    if (!MallocExtension_GetNumericProperty("generic.current_allocated_bytes",
+                                            &t_stats.activeBytes) ||
+        !MallocExtension_GetNumericProperty("generic.heap_size", &heapSize) ||
+        !MallocExtension_GetNumericProperty("tcmalloc.pageheap_unmapped_bytes", &unmappedBytes))
+        return false;
+
+    t_stats.mappedBytes = heapSize - unmappedBytes;
+    return true;
+}
+
+bool BenchmarkAllocatorPurge()
+{
+    MallocExtension_ReleaseFreeMemory();
+    return true;
+}
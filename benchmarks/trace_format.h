@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Binary allocation trace format, written by the trace_recorder LD_PRELOAD library and
+ * replayed by BM_TraceReplay. A trace file is a TraceHeader followed by TraceHeader::totalEvents
+ * fixed-size TraceEvent records.
+ *
+ * Object ids are recycled by the recorder once an object is freed, so they are always smaller
+ * than TraceHeader::totalObjects (the maximum number of simultaneously live objects). Replay uses
+ * them directly as indices into a slot table.
+ */
+namespace bm::trace {
+    constexpr char c_traceMagic[8] = { 'M', 'P', 'P', 'T', 'R', 'A', 'C', 'E' };
+    constexpr uint32_t c_traceVersion = 1;
+
+    enum class TraceOp : uint8_t
+    {
+        //! @brief objectId = malloc(size)
+        ALLOC = 0,
+        //! @brief objectId = aligned alloc(size) with alignment 1 << TraceEvent::arg
+        ALLOC_ALIGNED,
+        //! @brief objectId = calloc(1, size)
+        ALLOC_ZEROED,
+        //! @brief objectId = realloc(objectId, size)
+        REALLOC,
+        //! @brief free(objectId)
+        FREE,
+        COUNT
+    };
+
+    /**
+     * @brief Largest log2 alignment of ALLOC_ALIGNED events that replay accepts (2 MiB, a huge
+     * page). Alignments below sizeof(void*) are raised to it, as posix_memalign() requires.
+     */
+    constexpr uint8_t c_traceMaxAlignmentLog2 = 21;
+
+    struct TraceHeader
+    {
+        char magic[8];
+        uint32_t version;
+        //! @brief Number of distinct recording threads
+        uint32_t totalThreads;
+        //! @brief Number of TraceEvent records after the header
+        uint64_t totalEvents;
+        //! @brief Upper bound of all object ids in the trace
+        uint64_t totalObjects;
+    };
+
+    struct TraceEvent
+    {
+        TraceOp op;
+        //! @brief Op-specific argument (log2 of alignment for ALLOC_ALIGNED)
+        uint8_t arg;
+        //! @brief Recording thread (dense, starting from 0)
+        uint16_t threadId;
+        //! @brief Nanoseconds since the previous event (saturates at UINT32_MAX)
+        uint32_t timestampDelta;
+        uint32_t objectId;
+        //! @brief Requested size (unused for FREE)
+        uint32_t size;
+    };
+
+    static_assert(sizeof(TraceHeader) == 32, "TraceHeader layout changed");
+    static_assert(sizeof(TraceEvent) == 16, "TraceEvent layout changed");
+}
@@ -0,0 +1,572 @@
+/**
+ * @brief LD_PRELOAD library that records every malloc/calloc/realloc/aligned allocation/free of a
+ * process into the trace format from trace_format.h.
+ *
+ * Usage: MPP_TRACE_FILE=service.trace LD_PRELOAD=./libtrace_recorder.so ./service
+ * Without MPP_TRACE_FILE the trace is written to alloc-trace.<pid>.bin.
+ *
+ * All recorder state (pointer -> object id table, free ids, event buffer) lives in mmap'ed memory,
+ * so recording never calls back into the allocator being traced. Events from all threads are
+ * serialized with a spinlock, which is good enough for capturing traces, not for measuring.
+ */
+#include "trace_format.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+    using bm::trace::TraceEvent;
+    using bm::trace::TraceHeader;
+    using bm::trace::TraceOp;
+
+    using MallocFn = void* (*)(std::size_t);
+    using CallocFn = void* (*)(std::size_t, std::size_t);
+    using ReallocFn = void* (*)(void*, std::size_t);
+    using FreeFn = void (*)(void*);
+    using MemalignFn = void* (*)(std::size_t, std::size_t);
+    using PosixMemalignFn = int (*)(void**, std::size_t, std::size_t);
+
+    MallocFn g_realMalloc = nullptr;
+    CallocFn g_realCalloc = nullptr;
+    ReallocFn g_realRealloc = nullptr;
+    FreeFn g_realFree = nullptr;
+    MemalignFn g_realMemalign = nullptr;
+    MemalignFn g_realAlignedAlloc = nullptr;
+    PosixMemalignFn g_realPosixMemalign = nullptr;
+
+    //! @brief Serves allocations made by dlsym() while the real functions are being resolved.
+    alignas(64) char g_bootstrapHeap[64 << 10];
+    std::size_t g_bootstrapUsed = 0;
+
+    void* BootstrapAllocate(std::size_t t_size)
+    {
+        std::size_t aligned = (t_size + 15) & ~std::size_t(15);
+        if (g_bootstrapUsed + aligned > sizeof(g_bootstrapHeap))
+            return nullptr;
+        void* ptr = g_bootstrapHeap + g_bootstrapUsed;
+        g_bootstrapUsed += aligned;
+        return ptr;
+    }
+
+    bool IsBootstrapPtr(void* t_ptr)
+    {
+        return t_ptr >= g_bootstrapHeap && t_ptr < g_bootstrapHeap + sizeof(g_bootstrapHeap);
+    }
+
+    void* MapPages(std::size_t t_size)
+    {
+        void* ptr = mmap(nullptr, t_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return (ptr == MAP_FAILED) ? nullptr : ptr;
+    }
+
+    class SpinLock
+    {
+    public:
+        void Lock()
+        {
+            while (m_flag.test_and_set(std::memory_order_acquire)) {
+            }
+        }
+
+        void Unlock()
+        {
+            m_flag.clear(std::memory_order_release);
+        }
+
+    private:
+        std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+    };
+
+    /**
+     * @brief Linear-probing pointer -> (object id, size) table with backward-shift deletion, so
+     * there are no tombstones and lookups stay short under heavy alloc/free churn.
+     */
+    class PointerTable
+    {
+    public:
+        struct Entry
+        {
+            uintptr_t key;
+            uint32_t objectId;
+            uint32_t size;
+        };
+
+        bool Init(std::size_t t_capacity)
+        {
+            m_entries = static_cast<Entry*>(MapPages(t_capacity * sizeof(Entry)));
+            m_capacity = t_capacity;
+            m_count = 0;
+            return m_entries != nullptr;
+        }
+
+        bool Insert(uintptr_t t_key, uint32_t t_objectId, uint32_t t_size)
+        {
+            if ((m_count + 1) * 4 > m_capacity * 3 && !Grow())
+                return false;
+
+            std::size_t idx = Hash(t_key);
+            while (m_entries[idx].key != 0 && m_entries[idx].key != t_key)
+                idx = (idx + 1) & (m_capacity - 1);
+
+            if (m_entries[idx].key == 0)
+                ++m_count;
+            m_entries[idx] = Entry{ t_key, t_objectId, t_size };
+            return true;
+        }
+
+        //! @brief Removes t_key and stores its entry in t_entry. Returns false if not present.
+        bool Remove(uintptr_t t_key, Entry& t_entry)
+        {
+            std::size_t idx = Hash(t_key);
+            while (m_entries[idx].key != t_key) {
+                if (m_entries[idx].key == 0)
+                    return false;
+                idx = (idx + 1) & (m_capacity - 1);
+            }
+
+            t_entry = m_entries[idx];
+            --m_count;
+
+            // Backward-shift the following cluster into the hole
+            std::size_t hole = idx;
+            std::size_t next = (hole + 1) & (m_capacity - 1);
+            while (m_entries[next].key != 0) {
+                std::size_t home = Hash(m_entries[next].key);
+                if (((next - home) & (m_capacity - 1)) >= ((next - hole) & (m_capacity - 1))) {
+                    m_entries[hole] = m_entries[next];
+                    hole = next;
+                }
+                next = (next + 1) & (m_capacity - 1);
+            }
+            m_entries[hole].key = 0;
+
+            return true;
+        }
+
+    private:
+        Entry* m_entries = nullptr;
+        std::size_t m_capacity = 0;
+        std::size_t m_count = 0;
+
+        std::size_t Hash(uintptr_t t_key) const
+        {
+            return ((t_key >> 4) * UINT64_C(0x9E3779B97F4A7C15)) >> 20 & (m_capacity - 1);
+        }
+
+        bool Grow()
+        {
+            Entry* oldEntries = m_entries;
+            std::size_t oldCapacity = m_capacity;
+            if (!Init(oldCapacity * 2)) {
+                m_entries = oldEntries;
+                m_capacity = oldCapacity;
+                return false;
+            }
+
+            for (std::size_t i = 0; i < oldCapacity; ++i) {
+                if (oldEntries[i].key != 0)
+                    Insert(oldEntries[i].key, oldEntries[i].objectId, oldEntries[i].size);
+            }
+            munmap(oldEntries, oldCapacity * sizeof(Entry));
+            return true;
+        }
+    };
+
+    class Recorder
+    {
+    public:
+        void Start()
+        {
+            char defaultPath[64];
+            const char* path = getenv("MPP_TRACE_FILE");
+            if (path == nullptr) {
+                snprintf(defaultPath, sizeof(defaultPath), "alloc-trace.%d.bin", getpid());
+                path = defaultPath;
+            }
+
+            m_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            m_events = static_cast<TraceEvent*>(MapPages(c_bufferEvents * sizeof(TraceEvent)));
+            m_freeIds = static_cast<uint32_t*>(MapPages(c_maxObjects * sizeof(uint32_t)));
+            if (m_fd < 0 || m_events == nullptr || m_freeIds == nullptr ||
+                !m_pointers.Init(c_initialTableCapacity))
+                return;
+
+            // Placeholder, the real header is written by Stop()
+            TraceHeader header{};
+            WriteAll(&header, sizeof(header));
+            m_lastTimestamp = NowNs();
+            m_active.store(true, std::memory_order_release);
+        }
+
+        void Stop()
+        {
+            if (!m_active.exchange(false))
+                return;
+
+            m_lock.Lock();
+            Flush();
+            TraceHeader header{};
+            std::memcpy(header.magic, bm::trace::c_traceMagic, sizeof(header.magic));
+            header.version = bm::trace::c_traceVersion;
+            header.totalThreads = m_totalThreads.load();
+            header.totalEvents = m_totalEvents;
+            header.totalObjects = m_nextObjectId;
+            pwrite(m_fd, &header, sizeof(header), 0);
+            close(m_fd);
+            m_lock.Unlock();
+        }
+
+        bool IsActive() const
+        {
+            return m_active.load(std::memory_order_acquire);
+        }
+
+        void RecordAlloc(TraceOp t_op, void* t_ptr, std::size_t t_size, uint8_t t_arg = 0)
+        {
+            if (t_ptr == nullptr)
+                return;
+
+            m_lock.Lock();
+            uint32_t objectId = AcquireObjectId();
+            if (m_pointers.Insert(reinterpret_cast<uintptr_t>(t_ptr), objectId, ClampSize(t_size)))
+                Append(t_op, objectId, t_size, t_arg);
+            m_lock.Unlock();
+        }
+
+        void RecordFree(void* t_ptr)
+        {
+            if (t_ptr == nullptr)
+                return;
+
+            m_lock.Lock();
+            PointerTable::Entry entry;
+            // Chunks allocated before the recorder started are unknown, skip them
+            if (m_pointers.Remove(reinterpret_cast<uintptr_t>(t_ptr), entry))
+                RetireObject(entry);
+            m_lock.Unlock();
+        }
+
+        /**
+         * @brief Calls the real realloc() and updates the table under the lock, so that the old
+         * address can't be handed out to (and recorded by) another thread before it's retired.
+         */
+        void* Reallocate(void* t_oldPtr, std::size_t t_size)
+        {
+            m_lock.Lock();
+            void* newPtr = g_realRealloc(t_oldPtr, t_size);
+            PointerTable::Entry entry;
+            if (newPtr == nullptr) {
+                // realloc(ptr, 0) may free the chunk and return nullptr
+                if (t_size == 0 && t_oldPtr != nullptr &&
+                    m_pointers.Remove(reinterpret_cast<uintptr_t>(t_oldPtr), entry))
+                    RetireObject(entry);
+            } else if (t_oldPtr != nullptr &&
+                       m_pointers.Remove(reinterpret_cast<uintptr_t>(t_oldPtr), entry)) {
+                m_pointers.Insert(
+                    reinterpret_cast<uintptr_t>(newPtr), entry.objectId, ClampSize(t_size));
+                Append(TraceOp::REALLOC, entry.objectId, t_size, 0);
+            } else {
+                uint32_t objectId = AcquireObjectId();
+                m_pointers.Insert(reinterpret_cast<uintptr_t>(newPtr), objectId, ClampSize(t_size));
+                Append(TraceOp::ALLOC, objectId, t_size, 0);
+            }
+            m_lock.Unlock();
+            return newPtr;
+        }
+
+    private:
+        static constexpr std::size_t c_bufferEvents = 64 << 10;
+        static constexpr std::size_t c_maxObjects = 64 << 20;
+        static constexpr std::size_t c_initialTableCapacity = 1 << 16;
+
+        std::atomic<bool> m_active{ false };
+        SpinLock m_lock;
+        int m_fd = -1;
+
+        TraceEvent* m_events = nullptr;
+        std::size_t m_bufferedEvents = 0;
+        uint64_t m_totalEvents = 0;
+        uint64_t m_lastTimestamp = 0;
+
+        PointerTable m_pointers;
+        uint32_t* m_freeIds = nullptr;
+        std::size_t m_totalFreeIds = 0;
+        uint32_t m_nextObjectId = 0;
+
+        std::atomic<uint32_t> m_totalThreads{ 0 };
+
+        static thread_local uint32_t t_threadId __attribute__((tls_model("initial-exec")));
+
+        static uint64_t NowNs()
+        {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+        }
+
+        static uint32_t ClampSize(std::size_t t_size)
+        {
+            return t_size > std::numeric_limits<uint32_t>::max() ? std::numeric_limits<uint32_t>::max()
+                                                                 : static_cast<uint32_t>(t_size);
+        }
+
+        uint32_t GetThreadId()
+        {
+            if (t_threadId == std::numeric_limits<uint32_t>::max())
+                t_threadId = m_totalThreads.fetch_add(1);
+            return t_threadId;
+        }
+
+        uint32_t AcquireObjectId()
+        {
+            if (m_totalFreeIds != 0)
+                return m_freeIds[--m_totalFreeIds];
+            return m_nextObjectId++;
+        }
+
+        //! @brief Records the free of a removed table entry and recycles its object id.
+        void RetireObject(const PointerTable::Entry& t_entry)
+        {
+            Append(TraceOp::FREE, t_entry.objectId, 0, 0);
+            if (m_totalFreeIds < c_maxObjects)
+                m_freeIds[m_totalFreeIds++] = t_entry.objectId;
+        }
+
+        void Append(TraceOp t_op, uint32_t t_objectId, std::size_t t_size, uint8_t t_arg)
+        {
+            uint64_t now = NowNs();
+            uint64_t delta = now - m_lastTimestamp;
+            m_lastTimestamp = now;
+
+            TraceEvent& event = m_events[m_bufferedEvents++];
+            event.op = t_op;
+            event.arg = t_arg;
+            event.threadId = static_cast<uint16_t>(GetThreadId());
+            event.timestampDelta = delta > std::numeric_limits<uint32_t>::max()
+                                       ? std::numeric_limits<uint32_t>::max()
+                                       : static_cast<uint32_t>(delta);
+            event.objectId = t_objectId;
+            event.size = ClampSize(t_size);
+            ++m_totalEvents;
+
+            if (m_bufferedEvents == c_bufferEvents)
+                Flush();
+        }
+
+        void Flush()
+        {
+            WriteAll(m_events, m_bufferedEvents * sizeof(TraceEvent));
+            m_bufferedEvents = 0;
+        }
+
+        void WriteAll(const void* t_data, std::size_t t_size)
+        {
+            const char* data = static_cast<const char*>(t_data);
+            while (t_size != 0) {
+                ssize_t written = write(m_fd, data, t_size);
+                if (written < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    return;
+                }
+                data += written;
+                t_size -= written;
+            }
+        }
+    };
+
+    thread_local uint32_t Recorder::t_threadId __attribute__((tls_model("initial-exec"))) =
+        std::numeric_limits<uint32_t>::max();
+
+    Recorder g_recorder;
+
+    //! @brief Set while the current thread is inside the recorder, to not record its own calls.
+    thread_local bool t_insideRecorder __attribute__((tls_model("initial-exec"))) = false;
+
+    class RecursionGuard
+    {
+    public:
+        RecursionGuard()
+            : m_entered(!t_insideRecorder && g_recorder.IsActive())
+        {
+            if (m_entered)
+                t_insideRecorder = true;
+        }
+
+        ~RecursionGuard()
+        {
+            if (m_entered)
+                t_insideRecorder = false;
+        }
+
+        bool ShouldRecord() const
+        {
+            return m_entered;
+        }
+
+    private:
+        bool m_entered;
+    };
+
+    uint8_t Log2(std::size_t t_value)
+    {
+        return t_value == 0 ? 0 : static_cast<uint8_t>(63 - __builtin_clzll(t_value));
+    }
+
+    bool g_resolving = false;
+
+    /**
+     * @brief Looks up the next definitions of the allocation functions. Returns false while the
+     * lookup is in progress (dlsym() may allocate), callers then use the bootstrap heap.
+     */
+    bool EnsureRealFunctions()
+    {
+        if (g_realFree != nullptr)
+            return true;
+        if (g_resolving)
+            return false;
+
+        g_resolving = true;
+        g_realMalloc = reinterpret_cast<MallocFn>(dlsym(RTLD_NEXT, "malloc"));
+        g_realCalloc = reinterpret_cast<CallocFn>(dlsym(RTLD_NEXT, "calloc"));
+        g_realRealloc = reinterpret_cast<ReallocFn>(dlsym(RTLD_NEXT, "realloc"));
+        g_realMemalign = reinterpret_cast<MemalignFn>(dlsym(RTLD_NEXT, "memalign"));
+        g_realAlignedAlloc = reinterpret_cast<MemalignFn>(dlsym(RTLD_NEXT, "aligned_alloc"));
+        g_realPosixMemalign = reinterpret_cast<PosixMemalignFn>(dlsym(RTLD_NEXT, "posix_memalign"));
+        // Published last, it marks the lookup as finished
+        g_realFree = reinterpret_cast<FreeFn>(dlsym(RTLD_NEXT, "free"));
+        g_resolving = false;
+
+        return g_realFree != nullptr;
+    }
+
+    __attribute__((constructor)) void TraceRecorderStart()
+    {
+        if (!EnsureRealFunctions())
+            return;
+        t_insideRecorder = true;
+        g_recorder.Start();
+        t_insideRecorder = false;
+    }
+
+    __attribute__((destructor)) void TraceRecorderStop()
+    {
+        t_insideRecorder = true;
+        g_recorder.Stop();
+        t_insideRecorder = false;
+    }
+}
+
+extern "C" {
+    void* malloc(std::size_t t_size)
+    {
+        if (!EnsureRealFunctions())
+            return BootstrapAllocate(t_size);
+
+        RecursionGuard guard;
+        void* ptr = g_realMalloc(t_size);
+        if (guard.ShouldRecord())
+            g_recorder.RecordAlloc(TraceOp::ALLOC, ptr, t_size);
+        return ptr;
+    }
+
+    void* calloc(std::size_t t_count, std::size_t t_size)
+    {
+        // Bootstrap heap is zero-initialized and never reused
+        if (!EnsureRealFunctions()) {
+            std::size_t size;
+            if (__builtin_mul_overflow(t_count, t_size, &size)) {
+                errno = ENOMEM;
+                return nullptr;
+            }
+            return BootstrapAllocate(size);
+        }
+
+        RecursionGuard guard;
+        void* ptr = g_realCalloc(t_count, t_size);
+        if (guard.ShouldRecord())
+            g_recorder.RecordAlloc(TraceOp::ALLOC_ZEROED, ptr, t_count * t_size);
+        return ptr;
+    }
+
+    void* realloc(void* t_ptr, std::size_t t_size)
+    {
+        if (IsBootstrapPtr(t_ptr)) {
+            // Bootstrap chunks don't store their size, but none extends past the used part
+            const std::size_t oldSize =
+                g_bootstrapHeap + g_bootstrapUsed - static_cast<char*>(t_ptr);
+            void* ptr = malloc(t_size);
+            if (ptr != nullptr)
+                std::memcpy(ptr, t_ptr, std::min(t_size, oldSize));
+            return ptr;
+        }
+
+        if (!EnsureRealFunctions())
+            return nullptr;
+
+        RecursionGuard guard;
+        if (guard.ShouldRecord())
+            return g_recorder.Reallocate(t_ptr, t_size);
+        return g_realRealloc(t_ptr, t_size);
+    }
+
+    void free(void* t_ptr)
+    {
+        if (t_ptr == nullptr || IsBootstrapPtr(t_ptr) || !EnsureRealFunctions())
+            return;
+
+        RecursionGuard guard;
+        // Record before the real free, so that the address can't be reused by another thread first
+        if (guard.ShouldRecord())
+            g_recorder.RecordFree(t_ptr);
+        g_realFree(t_ptr);
+    }
+
+    void* memalign(std::size_t t_alignment, std::size_t t_size)
+    {
+        if (!EnsureRealFunctions())
+            return nullptr;
+
+        RecursionGuard guard;
+        void* ptr = g_realMemalign(t_alignment, t_size);
+        if (guard.ShouldRecord())
+            g_recorder.RecordAlloc(TraceOp::ALLOC_ALIGNED, ptr, t_size, Log2(t_alignment));
+        return ptr;
+    }
+
+    void* aligned_alloc(std::size_t t_alignment, std::size_t t_size)
+    {
+        if (!EnsureRealFunctions())
+            return nullptr;
+
+        RecursionGuard guard;
+        void* ptr = g_realAlignedAlloc(t_alignment, t_size);
+        if (guard.ShouldRecord())
+            g_recorder.RecordAlloc(TraceOp::ALLOC_ALIGNED, ptr, t_size, Log2(t_alignment));
+        return ptr;
+    }
+
+    int posix_memalign(void** t_ptr, std::size_t t_alignment, std::size_t t_size)
+    {
+        if (!EnsureRealFunctions())
+            return ENOMEM;
+
+        RecursionGuard guard;
+        int result = g_realPosixMemalign(t_ptr, t_alignment, t_size);
+        if (result == 0 && guard.ShouldRecord())
+            g_recorder.RecordAlloc(TraceOp::ALLOC_ALIGNED, *t_ptr, t_size, Log2(t_alignment));
+        return result;
+    }
+}
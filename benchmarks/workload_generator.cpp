@@ -0,0 +1,461 @@
+#include "workload_generator.h"
+#include "benchmark/benchmark.h"
+#include "benchmark_constants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace bm::workload {
+    namespace {
+        //! @brief Cells the density of a continuous distribution is integrated over
+        constexpr std::size_t c_densityCells = 1 << 16;
+        //! @brief Every value of a table has to be in [c_minValue, c_maxValue] (sizes, counts)
+        constexpr double c_minValue = 1;
+        constexpr double c_maxValue = std::numeric_limits<uint32_t>::max();
+
+        Workload g_workload;
+
+        template<class Table>
+        std::vector<uint32_t> CopyTable(const Table& t_table)
+        {
+            return std::vector<uint32_t>(t_table.begin(), t_table.end());
+        }
+
+        const std::map<std::string, std::vector<uint32_t>>& GetBuiltinTables()
+        {
+            static const std::map<std::string, std::vector<uint32_t>> c_tables = {
+                { "small", CopyTable(g_smallSizes) },   { "medium", CopyTable(g_mediumSizes) },
+                { "big", CopyTable(g_bigSizes) },       { "combined", CopyTable(g_combinedSizes) },
+                { "alloc", CopyTable(g_NumAllocOps) },  { "free", CopyTable(g_NumFreeOps) },
+            };
+            return c_tables;
+        }
+
+        std::string Trim(const std::string& t_str)
+        {
+            auto begin = t_str.find_first_not_of(" \t\r\n");
+            if (begin == std::string::npos)
+                return "";
+            return t_str.substr(begin, t_str.find_last_not_of(" \t\r\n") - begin + 1);
+        }
+
+        std::vector<std::string> Split(const std::string& t_str, char t_delimiter)
+        {
+            std::vector<std::string> parts;
+            std::istringstream stream(t_str);
+            std::string part;
+            while (std::getline(stream, part, t_delimiter))
+                parts.push_back(Trim(part));
+            return parts;
+        }
+
+        std::vector<double> ParseNumbers(const std::string& t_args,
+                                         std::size_t t_minCount,
+                                         std::size_t t_maxCount)
+        {
+            std::vector<double> numbers;
+            for (auto& arg : Split(t_args, ',')) {
+                numbers.push_back(std::stod(arg));
+                if (!std::isfinite(numbers.back()))
+                    throw std::runtime_error("parameters must be finite");
+            }
+
+            if (numbers.size() < t_minCount || numbers.size() > t_maxCount)
+                throw std::runtime_error("wrong number of parameters");
+            return numbers;
+        }
+
+        //! @brief Checks that [t_min, t_max] is a non-empty range of valid table values
+        void CheckBounds(double t_min, double t_max)
+        {
+            if (t_min < c_minValue || t_max > c_maxValue || t_min > t_max) {
+                throw std::runtime_error("bounds must satisfy 1 <= min <= max <= " +
+                                         std::to_string(std::numeric_limits<uint32_t>::max()));
+            }
+        }
+
+        /**
+         * @brief Evenly spaced quantiles of the discrete distribution t_points (value, weight).
+         */
+        std::vector<double> QuantilesOfPoints(
+            const std::vector<std::pair<double, double>>& t_points)
+        {
+            double total = 0;
+            for (auto& [value, weight] : t_points)
+                total += weight;
+            if (t_points.empty() || total <= 0)
+                throw std::runtime_error("distribution has no weight");
+
+            std::vector<double> quantiles;
+            quantiles.reserve(c_tableEntries);
+            std::size_t point = 0;
+            double cumulative = t_points[0].second;
+            for (std::size_t i = 0; i < c_tableEntries; ++i) {
+                double target = (i + 0.5) / c_tableEntries * total;
+                while (cumulative < target && point + 1 < t_points.size())
+                    cumulative += t_points[++point].second;
+                quantiles.push_back(t_points[point].first);
+            }
+
+            return quantiles;
+        }
+
+        /**
+         * @brief Evenly spaced quantiles of the continuous distribution with (unnormalized)
+         * density t_density over [t_lo, t_hi]. The density is evaluated at cell midpoints, so it
+         * may be infinite at the bounds.
+         */
+        template<class Density>
+        std::vector<double> QuantilesOfDensity(Density t_density, double t_lo, double t_hi)
+        {
+            if (!(t_hi > t_lo))
+                throw std::runtime_error("empty range");
+
+            const double cellWidth = (t_hi - t_lo) / c_densityCells;
+            std::vector<double> cumulative(c_densityCells);
+            double total = 0;
+            for (std::size_t cell = 0; cell < c_densityCells; ++cell) {
+                total += t_density(t_lo + (cell + 0.5) * cellWidth);
+                cumulative[cell] = total;
+            }
+            if (!(total > 0) || !std::isfinite(total))
+                throw std::runtime_error("density can't be integrated");
+
+            std::vector<double> quantiles;
+            quantiles.reserve(c_tableEntries);
+            for (std::size_t i = 0; i < c_tableEntries; ++i) {
+                double target = (i + 0.5) / c_tableEntries * total;
+                std::size_t cell =
+                    std::lower_bound(cumulative.begin(), cumulative.end(), target) -
+                    cumulative.begin();
+                cell = std::min(cell, c_densityCells - 1);
+
+                // Linear inside of the cell
+                double cellStart = cell ? cumulative[cell - 1] : 0;
+                double fraction = (target - cellStart) / (cumulative[cell] - cellStart);
+                quantiles.push_back(t_lo + (cell + fraction) * cellWidth);
+            }
+
+            return quantiles;
+        }
+
+        std::vector<std::pair<double, double>> ReadHistogram(const std::string& t_path)
+        {
+            std::ifstream file(t_path);
+            if (!file)
+                throw std::runtime_error("can't open " + t_path);
+
+            std::vector<std::pair<double, double>> points;
+            std::string line;
+            while (std::getline(file, line)) {
+                line = Trim(line.substr(0, line.find('#')));
+                if (line.empty())
+                    continue;
+
+                std::replace(line.begin(), line.end(), ',', ' ');
+                std::istringstream fields(line);
+                double value;
+                double weight;
+                if (!(fields >> value >> weight))
+                    throw std::runtime_error("bad histogram line \"" + line + "\" in " + t_path);
+                if (!(weight >= 0) || !std::isfinite(weight))
+                    throw std::runtime_error("negative weight \"" + line + "\" in " + t_path);
+                points.emplace_back(value, weight);
+            }
+
+            std::sort(points.begin(), points.end());
+            return points;
+        }
+
+        std::vector<double> BuildQuantiles(const std::string& t_kind, const std::string& t_args)
+        {
+            if (t_kind == "uniform") {
+                auto params = ParseNumbers(t_args, 2, 2);
+                CheckBounds(params[0], params[1]);
+                // Every integer in [min, max] gets a cell of the same width
+                return QuantilesOfDensity([](double) { return 1.0; }, params[0], params[1] + 1);
+            }
+
+            if (t_kind == "beta") {
+                auto params = ParseNumbers(t_args, 4, 4);
+                const double a = params[0];
+                const double b = params[1];
+                if (!(a > 0) || !(b > 0))
+                    throw std::runtime_error("a and b must be positive");
+                CheckBounds(params[2], params[3]);
+                auto quantiles = QuantilesOfDensity(
+                    [a, b](double x) { return std::pow(x, a - 1) * std::pow(1 - x, b - 1); }, 0, 1);
+                for (auto& quantile : quantiles)
+                    quantile = params[2] + quantile * (params[3] - params[2]);
+                return quantiles;
+            }
+
+            if (t_kind == "lognormal") {
+                auto params = ParseNumbers(t_args, 2, 4);
+                if (!(params[0] > 0) || !(params[1] > 0))
+                    throw std::runtime_error("median and sigma must be positive");
+                if (params.size() > 2)
+                    CheckBounds(params[2], params.size() > 3 ? params[3] : c_maxValue);
+                const double mu = std::log(params[0]);
+                const double sigma = params[1];
+                double lo = mu - 6 * sigma;
+                double hi = mu + 6 * sigma;
+                if (params.size() > 2)
+                    lo = std::max(lo, std::log(std::max(params[2], 1.0)));
+                if (params.size() > 3)
+                    hi = std::min(hi, std::log(params[3] + 1));
+
+                auto quantiles = QuantilesOfDensity(
+                    [mu, sigma](double z) {
+                        return std::exp(-(z - mu) * (z - mu) / (2 * sigma * sigma));
+                    },
+                    lo,
+                    hi);
+                for (auto& quantile : quantiles)
+                    quantile = std::exp(quantile);
+                return quantiles;
+            }
+
+            if (t_kind == "zipf") {
+                auto params = ParseNumbers(t_args, 3, 4);
+                const double step = params.size() > 3 ? params[3] : 16;
+                if (!(step > 0))
+                    throw std::runtime_error("step must be positive");
+                CheckBounds(params[1], params[2]);
+
+                std::vector<std::pair<double, double>> points;
+                for (double value = params[1], rank = 1; value <= params[2]; value += step, ++rank)
+                    points.emplace_back(value, 1 / std::pow(rank, params[0]));
+                return QuantilesOfPoints(points);
+            }
+
+            if (t_kind == "hist")
+                return QuantilesOfPoints(ReadHistogram(t_args));
+
+            throw std::runtime_error("unknown distribution \"" + t_kind + "\"");
+        }
+
+        std::vector<uint32_t> BuildTable(const std::string& t_spec)
+        {
+            auto colon = t_spec.find(':');
+            if (colon == std::string::npos)
+                throw std::runtime_error("expected <distribution>:<parameters>");
+            const std::string kind = Trim(t_spec.substr(0, colon));
+            const std::string args = Trim(t_spec.substr(colon + 1));
+
+            if (kind == "builtin") {
+                auto table = GetBuiltinTables().find(args);
+                if (table == GetBuiltinTables().end())
+                    throw std::runtime_error("unknown built-in table \"" + args + "\"");
+                return table->second;
+            }
+
+            if (kind == "mix") {
+                // Split() drops a trailing empty part
+                if (args.empty() || args.back() == '|')
+                    throw std::runtime_error("empty component in a mixture");
+
+                std::vector<std::pair<double, std::vector<uint32_t>>> components;
+                double totalWeight = 0;
+                for (auto& component : Split(args, '|')) {
+                    if (component.empty())
+                        throw std::runtime_error("empty component in a mixture");
+                    auto at = component.find('@');
+                    if (at == std::string::npos)
+                        throw std::runtime_error("expected <weight>@<spec> in a mixture");
+                    double weight = std::stod(component.substr(0, at));
+                    // A weight <= 0 would make the entry count of a component negative
+                    if (!(weight > 0) || !std::isfinite(weight))
+                        throw std::runtime_error("weight must be positive and finite");
+                    components.emplace_back(weight, BuildTable(Trim(component.substr(at + 1))));
+                    totalWeight += weight;
+                }
+                if (!(totalWeight > 0))
+                    throw std::runtime_error("mixture has no weight");
+
+                // Every component gets its share of the entries, taken evenly from its own table
+                std::vector<uint32_t> table;
+                double share = 0;
+                for (auto& [weight, componentTable] : components) {
+                    share += weight / totalWeight;
+                    std::size_t entries =
+                        static_cast<std::size_t>(std::lround(share * c_tableEntries)) -
+                        table.size();
+                    for (std::size_t i = 0; i < entries; ++i)
+                        table.push_back(componentTable[i * componentTable.size() / entries]);
+                }
+                return table;
+            }
+
+            std::vector<uint32_t> table;
+            for (double quantile : BuildQuantiles(kind, args)) {
+                // Also catches values of the lognormal tail and of histograms
+                if (!(quantile >= c_minValue) || !(quantile < c_maxValue + 1)) {
+                    throw std::runtime_error("value " + std::to_string(quantile) +
+                                             " is outside of [1, " +
+                                             std::to_string(std::numeric_limits<uint32_t>::max()) +
+                                             "]");
+                }
+                table.push_back(static_cast<uint32_t>(std::floor(quantile)));
+            }
+            return table;
+        }
+
+        bool SetDistribution(std::optional<Distribution>& t_distribution,
+                             const std::string& t_name,
+                             const std::string& t_spec,
+                             uint32_t t_minValue)
+        {
+            try {
+                t_distribution = Distribution::Parse(t_spec, t_minValue);
+                return true;
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid workload " << t_name << " \"" << t_spec << "\": " << e.what()
+                          << std::endl;
+                return false;
+            }
+        }
+
+        /**
+         * @brief Every chunk of BM_Complex stores its size in the first 8 bytes, so smaller
+         * requests are raised to that.
+         */
+        constexpr uint32_t c_minRequestSize = sizeof(int64_t);
+
+        bool SetByName(const std::string& t_name, const std::string& t_spec)
+        {
+            if (t_name == "sizes")
+                return SetDistribution(g_workload.sizes, t_name, t_spec, c_minRequestSize);
+            if (t_name == "alloc_bursts")
+                return SetDistribution(g_workload.allocBursts, t_name, t_spec, 0);
+            if (t_name == "free_bursts")
+                return SetDistribution(g_workload.freeBursts, t_name, t_spec, 0);
+            if (t_name == "request_lifetimes")
+                return SetDistribution(g_workload.requestLifetimes, t_name, t_spec, 1);
+            if (t_name == "session_lifetimes")
+                return SetDistribution(g_workload.sessionLifetimes, t_name, t_spec, 1);
+
+            std::cerr << "Unknown workload parameter \"" << t_name << "\"" << std::endl;
+            return false;
+        }
+
+        bool ReadWorkloadFile(const std::string& t_path)
+        {
+            std::ifstream file(t_path);
+            if (!file) {
+                std::cerr << "Can't open workload file " << t_path << std::endl;
+                return false;
+            }
+
+            std::string line;
+            while (std::getline(file, line)) {
+                line = Trim(line.substr(0, line.find('#')));
+                if (line.empty())
+                    continue;
+
+                auto equals = line.find('=');
+                if (equals == std::string::npos) {
+                    std::cerr << "Expected <name> = <spec> in " << t_path << ": " << line
+                              << std::endl;
+                    return false;
+                }
+                if (!SetByName(Trim(line.substr(0, equals)), Trim(line.substr(equals + 1))))
+                    return false;
+            }
+
+            return true;
+        }
+    }
+
+    Distribution Distribution::Parse(const std::string& t_spec, uint32_t t_minValue)
+    {
+        Distribution distribution;
+        try {
+            distribution.m_table = BuildTable(t_spec);
+        } catch (const std::logic_error&) {
+            // std::stod and friends
+            throw std::runtime_error("bad number");
+        }
+
+        if (distribution.m_table.empty())
+            throw std::runtime_error("distribution is empty");
+        for (auto& value : distribution.m_table)
+            value = std::max(value, t_minValue);
+        distribution.m_spec = t_spec;
+        return distribution;
+    }
+
+    bool ParseArguments(int& t_argc, char** t_argv)
+    {
+        std::string file;
+        std::vector<std::pair<std::string, std::string>> overrides;
+
+        int kept = 1;
+        for (int i = 1; i < t_argc; ++i) {
+            const char* arg = t_argv[i];
+            if (std::strncmp(arg, "--workload=", std::strlen("--workload=")) == 0) {
+                file = arg + std::strlen("--workload=");
+            } else if (std::strncmp(arg, "--workload_", std::strlen("--workload_")) == 0 &&
+                       std::strchr(arg, '=') != nullptr) {
+                const char* name = arg + std::strlen("--workload_");
+                const char* equals = std::strchr(arg, '=');
+                overrides.emplace_back(std::string(name, equals), equals + 1);
+            } else {
+                t_argv[kept++] = t_argv[i];
+            }
+        }
+        t_argc = kept;
+
+        if (!file.empty() && !ReadWorkloadFile(file))
+            return false;
+        for (auto& [name, spec] : overrides) {
+            if (!SetByName(name, spec))
+                return false;
+        }
+
+        if (g_workload.sizes)
+            ::benchmark::AddCustomContext("workload_sizes", g_workload.sizes->GetSpec());
+        if (g_workload.allocBursts) {
+            ::benchmark::AddCustomContext("workload_alloc_bursts",
+                                          g_workload.allocBursts->GetSpec());
+        }
+        if (g_workload.freeBursts)
+            ::benchmark::AddCustomContext("workload_free_bursts", g_workload.freeBursts->GetSpec());
+        if (g_workload.requestLifetimes) {
+            ::benchmark::AddCustomContext("workload_request_lifetimes",
+                                          g_workload.requestLifetimes->GetSpec());
+        }
+        if (g_workload.sessionLifetimes) {
+            ::benchmark::AddCustomContext("workload_session_lifetimes",
+                                          g_workload.sessionLifetimes->GetSpec());
+        }
+        return true;
+    }
+
+    const Workload& GetWorkload()
+    {
+        return g_workload;
+    }
+
+    const Distribution& GetSizes(const char* t_builtin)
+    {
+        if (g_workload.sizes)
+            return *g_workload.sizes;
+
+        static const std::map<std::string, Distribution> c_builtins = [] {
+            std::map<std::string, Distribution> builtins;
+            for (const char* name : { "small", "medium", "big", "combined" })
+                builtins.emplace(name, Distribution::Parse(std::string("builtin:") + name));
+            return builtins;
+        }();
+        return c_builtins.at(t_builtin);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "benchmark_utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Request size and burst length distributions, built at startup from a textual spec
+ * instead of the tables compiled into benchmark_constants.h. Specs:
+ * - `builtin:<small|medium|big|combined|alloc|free>` - the tables from benchmark_constants.h
+ * - `uniform:<min>,<max>`
+ * - `beta:<a>,<b>,<min>,<max>` - Beta(a, b) scaled to [min, max]
+ * - `lognormal:<median>,<sigma>[,<min>,<max>]` - sigma of ln(value), truncated to [min, max]
+ * - `zipf:<s>,<min>,<max>[,<step>]` - value min + (k - 1) * step (default step 16) has weight
+ *   1 / k^s
+ * - `hist:<path>` - empirical histogram, "<value> <weight>" per line ('#' starts a comment)
+ * - `mix:<weight>@<spec>|<weight>@<spec>...` - weighted mixture of the above
+ */
+namespace bm::workload {
+    //! @brief Entries of a generated table, same as the size tables in benchmark_constants.h
+    constexpr std::size_t c_tableEntries = 2048;
+
+    /**
+     * @brief Discrete distribution materialized as a lookup table of evenly spaced quantiles, so
+     * that sampling costs the same as indexing the built-in tables. Has operator[] and size(), so
+     * it can be used wherever those tables are.
+     */
+    class Distribution
+    {
+    public:
+        /**
+         * @brief Builds the distribution described by t_spec.
+         * @param t_minValue Generated values below it are raised to it
+         * @throw std::runtime_error If the spec is invalid
+         */
+        static Distribution Parse(const std::string& t_spec, uint32_t t_minValue = 0);
+
+        uint32_t Sample(uint64_t& t_rngState) const
+        {
+            return m_table[bm::utils::XorshiftNext(t_rngState) % m_table.size()];
+        }
+
+        uint32_t operator[](std::size_t t_idx) const
+        {
+            return m_table[t_idx];
+        }
+
+        std::size_t size() const
+        {
+            return m_table.size();
+        }
+
+        const std::string& GetSpec() const
+        {
+            return m_spec;
+        }
+
+    private:
+        std::vector<uint32_t> m_table;
+        std::string m_spec;
+    };
+
+    //! @brief Distributions configured for this run, unset ones keep the benchmark's defaults.
+    struct Workload
+    {
+        //! @brief Request sizes of BM_Complex and of the alloc/dealloc benchmarks
+        std::optional<Distribution> sizes;
+        //! @brief Chunks per BM_Complex "allocate many" step
+        std::optional<Distribution> allocBursts;
+        //! @brief Chunks per BM_Complex "deallocate many" step
+        std::optional<Distribution> freeBursts;
+        //! @brief Lifetimes (in allocations) of request-scoped objects of BM_Lifetimes
+        std::optional<Distribution> requestLifetimes;
+        //! @brief Lifetimes (in allocations) of session-scoped objects of BM_Lifetimes
+        std::optional<Distribution> sessionLifetimes;
+    };
+
+    /**
+     * @brief Builds the workload from --workload=<file> (lines of "<name> = <spec>") and
+     * --workload_<name>=<spec>, which take precedence over the file. Names are sizes,
+     * alloc_bursts, free_bursts, request_lifetimes and session_lifetimes. Consumed arguments are
+     * removed from t_argv. Recognized specs are added to the benchmark context.
+     * @return false (after printing the error) if the workload is invalid
+     */
+    bool ParseArguments(int& t_argc, char** t_argv);
+
+    const Workload& GetWorkload();
+
+    //! @return The configured size distribution, or the built-in table t_builtin (e.g. "combined")
+    const Distribution& GetSizes(const char* t_builtin);
+}
@@ -1,17 +1,26 @@
 #!/bin/bash
-CXX=/usr/bin/clang++-15 CC=/usr/bin/clang-15 cmake -S . -B build -DMPP_BENCH_ONLY_MEMPLUSPLUS=OFF -DCMAKE_EXPORT_COMPILE_COMMANDS=On -DCMAKE_BUILD_TYPE=Release -DCMAKE_C_COMPILER=/usr/bin/clang-15 -DCMAKE_CXX_COMPILER=/usr/bin/clang++-15
-CXX=/usr/bin/clang++-15 CC=/usr/bin/clang-15 cmake --build build --target all -- -j 16
+# GLIBC_TUNABLES of the ptmalloc2-tcache target, also baked into the target to check the environment
+export MPP_BENCH_GLIBC_TUNABLES="${MPP_BENCH_GLIBC_TUNABLES:-glibc.malloc.tcache_count=1024}"
 
-# Benchmarks default allocation/deallocation speed
-# ./build/benchmarks/gcpp/benchmark-gcpp
+CXX=/usr/bin/clang++-15 CC=/usr/bin/clang-15 cmake -S . -B build -DMPP_BENCH_ONLY_MEMPLUSPLUS=OFF -DMPP_BENCH_GLIBC_TUNABLES="$MPP_BENCH_GLIBC_TUNABLES" -DCMAKE_EXPORT_COMPILE_COMMANDS=On -DCMAKE_BUILD_TYPE=Release -DCMAKE_C_COMPILER=/usr/bin/clang-15 -DCMAKE_CXX_COMPILER=/usr/bin/clang++-15
+CXX=/usr/bin/clang++-15 CC=/usr/bin/clang-15 cmake --build build --target all -- -j 16
 
 curr_date=$(date -u +"%Y-%m-%dT-%H_%M_%SZ")
 
 mkdir -p ./bench-results/$curr_date
 
-./build/benchmarks/jemalloc/benchmark-jemalloc --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/jemalloc.json" --benchmark_repetitions=5 
-./build/benchmarks/mempp/benchmark-mpp --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/mpp.json" --benchmark_repetitions=5
-./build/benchmarks/ptmalloc2/benchmark-ptmalloc2 --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/ptmalloc2.json" --benchmark_repetitions=5
-./build/benchmarks/ptmalloc3/benchmark-ptmalloc3 --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/ptmalloc3.json" --benchmark_repetitions=5
-./build/benchmarks/rpmalloc/benchmark-rpmalloc --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/rpmalloc.json" --benchmark_repetitions=5
-./build/benchmarks/mimalloc/benchmark-mimalloc --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/mimalloc.json" --benchmark_repetitions=5
+# Run every benchmark family in a fresh process, so that results don't depend on benchmark order
+export MPP_BENCH_ISOLATE=family
+
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/baseline-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/baseline-rss.csv" ./build/benchmarks/baseline/benchmark-baseline --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/baseline.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/jemalloc-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/jemalloc-rss.csv" ./build/benchmarks/jemalloc/benchmark-jemalloc --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/jemalloc.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/mpp-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/mpp-rss.csv" ./build/benchmarks/mempp/benchmark-mpp --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/mpp.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/gcpp-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/gcpp-rss.csv" ./build/benchmarks/gcpp/benchmark-gcpp --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/gcpp.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/ptmalloc2-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/ptmalloc2-rss.csv" ./build/benchmarks/ptmalloc2/benchmark-ptmalloc2 --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/ptmalloc2.json" --benchmark_repetitions=5
+GLIBC_TUNABLES="$MPP_BENCH_GLIBC_TUNABLES" MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/ptmalloc2-tcache-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/ptmalloc2-tcache-rss.csv" ./build/benchmarks/ptmalloc2-tcache/benchmark-ptmalloc2-tcache --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/ptmalloc2-tcache.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/ptmalloc3-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/ptmalloc3-rss.csv" ./build/benchmarks/ptmalloc3/benchmark-ptmalloc3 --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/ptmalloc3.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/rpmalloc-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/rpmalloc-rss.csv" ./build/benchmarks/rpmalloc/benchmark-rpmalloc --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/rpmalloc.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/mimalloc-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/mimalloc-rss.csv" ./build/benchmarks/mimalloc/benchmark-mimalloc --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/mimalloc.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/tcmalloc-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/tcmalloc-rss.csv" ./build/benchmarks/tcmalloc/benchmark-tcmalloc --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/tcmalloc.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/snmalloc-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/snmalloc-rss.csv" ./build/benchmarks/snmalloc/benchmark-snmalloc --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/snmalloc.json" --benchmark_repetitions=5
+MPP_BENCH_SIZE_CLASS_LOG="./bench-results/$curr_date/hoard-size-classes.csv" MPP_BENCH_RSS_TIMELINE="./bench-results/$curr_date/hoard-rss.csv" ./build/benchmarks/hoard/benchmark-hoard --benchmark_out_format=json --benchmark_out="./bench-results/$curr_date/hoard.json" --benchmark_repetitions=5
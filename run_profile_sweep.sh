@@ -0,0 +1,28 @@
+#!/bin/bash
+# Runs every allocator target once per tuning profile it knows (benchmark-<x> --list_profiles).
+# Expects the targets built by compile_all_and_run.sh. Extra arguments are passed to every run,
+# e.g. ./run_profile_sweep.sh --benchmark_filter=BM_Complex
+curr_date=$(date -u +"%Y-%m-%dT-%H_%M_%SZ")
+out_dir=./bench-results/$curr_date/profiles
+
+mkdir -p $out_dir
+
+export MPP_BENCH_ISOLATE=family
+
+# Has to match the value compile_all_and_run.sh built the ptmalloc2-tcache target with
+MPP_BENCH_GLIBC_TUNABLES="${MPP_BENCH_GLIBC_TUNABLES:-glibc.malloc.tcache_count=1024}"
+
+for target in ./build/benchmarks/*/benchmark-*; do
+    allocator=$(basename $target)
+    allocator=${allocator#benchmark-}
+
+    # glibc reads its tunables at startup only, see benchmarks/ptmalloc2-tcache
+    tunables=""
+    if [ "$allocator" = "ptmalloc2-tcache" ]; then
+        tunables="$MPP_BENCH_GLIBC_TUNABLES"
+    fi
+
+    for profile in $($target --list_profiles); do
+        GLIBC_TUNABLES="$tunables" MPP_BENCH_PROFILE="$profile" MPP_BENCH_RSS_TIMELINE="$out_dir/$allocator-$profile-rss.csv" $target --benchmark_out_format=json --benchmark_out="$out_dir/$allocator-$profile.json" --benchmark_repetitions=3 "$@"
+    done
+done